@@ -0,0 +1,664 @@
+#ifndef RADIX_BURST_TREE
+#define RADIX_BURST_TREE
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include "radix_tree.h"
+
+template <typename K, typename T> class radix_burst_tree;
+template <typename K, typename T> class radix_burst_it;
+
+/**
+ * @brief 混合基数树的节点
+ * 节点有两种形态：
+ *  -桶节点：没有子节点，m_bucket中按序存放该节点之下的所有后缀及其值
+ *  -内部节点：有子节点，m_bucket中至多存放一个空后缀，即恰好在该节点结束的序列
+ */
+template <typename K, typename T>
+class radix_burst_node
+{
+    friend class radix_burst_tree<K, T>;
+    friend class radix_burst_it<K, T>;
+
+    typedef std::pair<K, T> entry_type;
+    typedef typename std::map<K, radix_burst_node<K, T> *>::iterator iterator_child;
+
+private:
+    //成员变量
+
+    /**
+     * @note 父节点到该节点的边上的部分序列，等于父节点map中的key
+     */
+    K m_key;
+
+    /**
+     * @note 后缀相对于该节点末尾，连续存放并按K的顺序排列
+     */
+    std::vector<entry_type> m_bucket;
+
+    std::map<K, radix_burst_node<K, T> *> m_children;
+    radix_burst_node<K, T> *m_parent;
+
+    //构造函数
+    radix_burst_node() : m_key(), m_bucket(), m_children(), m_parent(NULL) {}
+
+    ~radix_burst_node()
+    {
+        iterator_child it;
+        for (it = m_children.begin(); it != m_children.end(); ++it)
+            delete it->second;
+    }
+};
+
+template <typename K, typename T>
+class radix_burst_it : public std::iterator<std::forward_iterator_tag, std::pair<const K, T> >
+{
+    friend class radix_burst_tree<K, T>;
+
+public:
+    typedef radix_pair_ref<K, T> reference;
+
+    //构造函数
+    radix_burst_it() : m_node(NULL), m_index(0) {}
+
+    //重载运算符
+    /**
+     * @note 桶中只存放后缀，完整序列沿父节点重建，复杂度与节点深度成正比
+     */
+    reference operator*() const
+    {
+        return reference(get_key(), m_node->m_bucket[m_index].second);
+    }
+
+    reference operator->() const
+    {
+        return **this;
+    }
+
+    radix_burst_it<K, T> &operator++()
+    {
+        if (m_node != NULL)
+            next();
+        return *this;
+    }
+
+    radix_burst_it<K, T> operator++(int)
+    {
+        radix_burst_it<K, T> copy(*this);
+        ++(*this);
+        return copy;
+    }
+
+    bool operator!=(const radix_burst_it<K, T> &r) const
+    {
+        return m_node != r.m_node || m_index != r.m_index;
+    }
+
+    bool operator==(const radix_burst_it<K, T> &r) const
+    {
+        return m_node == r.m_node && m_index == r.m_index;
+    }
+
+private:
+    //成员变量
+    radix_burst_node<K, T> *m_node;
+    std::size_t m_index;
+
+    //构造函数
+    radix_burst_it(radix_burst_node<K, T> *node, std::size_t index) : m_node(node), m_index(index) {}
+
+    //基本函数
+    K get_key() const
+    {
+        K key = m_node->m_bucket[m_index].first;
+        for (radix_burst_node<K, T> *node = m_node; node->m_parent != NULL; node = node->m_parent)
+            key = radix_join(node->m_key, key);
+        return key;
+    }
+
+    /**
+     * @brief 先遍历本节点桶中的下一个元素，再进入子节点，最后沿父节点寻找下一个兄弟节点
+     */
+    void next()
+    {
+        if (m_index + 1 < m_node->m_bucket.size())
+        {
+            m_index++;
+            return;
+        }
+
+        m_index = 0;
+        radix_burst_node<K, T> *node = m_node;
+        if (!node->m_children.empty())
+        {
+            m_node = get_first_node(node->m_children.begin()->second);
+            return;
+        }
+
+        while (node->m_parent != NULL)
+        {
+            radix_burst_node<K, T> *parent = node->m_parent;
+            typename radix_burst_node<K, T>::iterator_child it = parent->m_children.find(node->m_key);
+            ++it;
+            if (it != parent->m_children.end())
+            {
+                m_node = get_first_node(it->second);
+                return;
+            }
+            node = parent;
+        }
+        m_node = NULL;
+    }
+
+    /**
+     * @brief 返回子树中首个桶非空的节点，根节点以外的子树都至少包含一个元素
+     */
+    static radix_burst_node<K, T> *get_first_node(radix_burst_node<K, T> *node)
+    {
+        while (node->m_bucket.empty())
+            node = node->m_children.begin()->second;
+        return node;
+    }
+};
+
+/**
+ * @brief 混合基数树（burst trie）
+ * 元素数量不超过burst_size的子树以桶的形式连续存放后缀和值，桶中元素超过burst_size时
+ * 分裂（burst）为内部节点和若干子桶，分裂时提取各子桶的公共前缀作为边。
+ * @note 插入、删除或分裂会使指向同一个桶的迭代器失效
+ */
+template <typename K, typename T>
+class radix_burst_tree
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef radix_burst_it<K, T> iterator;
+    typedef std::size_t size_type;
+
+    //构造函数
+    /**
+     * @par burst_size 桶中元素个数的上限，需要大于零
+     */
+    explicit radix_burst_tree(size_type burst_size = 16) : m_size(0), m_burst_size(burst_size), m_root(NULL)
+    {
+        assert(burst_size > 0);
+    }
+    ~radix_burst_tree()
+    {
+        delete m_root;
+    }
+
+    //成员函数
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void clear()
+    {
+        delete m_root;
+        m_root = NULL;
+        m_size = 0;
+    }
+
+    /**
+     * @brief 获取桶中元素个数的上限
+     */
+    size_type burst_size() const
+    {
+        return m_burst_size;
+    }
+
+    /**
+     * @brief 返回树中首个元素的迭代器，树为空时返回空的迭代器
+     */
+    iterator begin();
+
+    /**
+     * @brief 返回空的迭代器
+     */
+    iterator end();
+
+    /**
+     * @brief 根据key返回完全匹配的元素的迭代器，若无完全匹配的结果则返回空的迭代器
+     */
+    iterator find(const K &key);
+
+    /**
+     * @brief 寻找树中能够最长前缀匹配key的元素，若没有返回空迭代器
+     */
+    iterator longest_match(const K &key);
+
+    /**
+     * @brief 在树中寻找以key为前缀的所有元素，结果按序排列
+     * @par key 为空匹配树中所有元素
+     */
+    void prefix_match(const K &key, std::vector<iterator> &vec);
+
+    /**
+     * @brief 插入元素，插入成功返回新元素的迭代器和true，已存在时返回原有元素和false
+     */
+    std::pair<iterator, bool> insert(const value_type &val);
+
+    T &operator[](const K &key);
+
+    void erase(iterator it);
+
+    bool erase(const K &key);
+
+private:
+    typedef typename radix_burst_node<K, T>::entry_type entry_type;
+    typedef typename std::vector<entry_type>::iterator iterator_entry;
+
+    size_type m_size;
+    size_type m_burst_size;
+    radix_burst_node<K, T> *m_root;
+
+    /**
+     * @brief 沿key向下查找，返回路径是key前缀的最深节点
+     * @par matched 返回该节点末尾在key中的下标
+     */
+    radix_burst_node<K, T> *locate(const K &key, int &matched) const;
+
+    /**
+     * @brief 在node中查找首元素等于key[pos]的子节点，不存在时返回NULL
+     */
+    static radix_burst_node<K, T> *find_child(radix_burst_node<K, T> *node, const K &key, int pos);
+
+    /**
+     * @brief 统计key1从pos1开始与key2从pos2开始的公共前缀长度
+     */
+    static int common_prefix(const K &key1, int pos1, const K &key2, int pos2);
+
+    /**
+     * @brief 在桶中二分查找不小于suffix的位置
+     */
+    static iterator_entry lower_bound(radix_burst_node<K, T> *node, const K &suffix);
+
+    static bool entry_less(const entry_type &entry, const K &suffix)
+    {
+        return entry.first < suffix;
+    }
+
+    /**
+     * @brief 在node的前count个元素处将其拆分，公共前缀作为新的父节点
+     */
+    static radix_burst_node<K, T> *split_node(radix_burst_node<K, T> *node, int count);
+
+    /**
+     * @brief 将元素个数超过上限的桶节点分裂为内部节点，子桶超过上限时继续分裂
+     */
+    void burst(radix_burst_node<K, T> *node);
+
+    /**
+     * @brief 删除元素后删除空节点，并将只剩一个子节点的内部节点与子节点合并
+     */
+    void prune(radix_burst_node<K, T> *node);
+
+    /**
+     * @brief 将node为根的子树中的所有元素按序添加到vec中
+     */
+    static void get_entries(radix_burst_node<K, T> *node, std::vector<iterator> &vec);
+
+    //禁止复制
+    radix_burst_tree(const radix_burst_tree &);
+    radix_burst_tree &operator=(const radix_burst_tree &);
+};
+
+template <typename K, typename T>
+typename radix_burst_tree<K, T>::iterator radix_burst_tree<K, T>::begin()
+{
+    if (m_size == 0)
+        return end();
+    return iterator(iterator::get_first_node(m_root), 0);
+}
+
+template <typename K, typename T>
+typename radix_burst_tree<K, T>::iterator radix_burst_tree<K, T>::end()
+{
+    return iterator(NULL, 0);
+}
+
+template <typename K, typename T>
+typename radix_burst_tree<K, T>::iterator radix_burst_tree<K, T>::find(const K &key)
+{
+    if (m_root == NULL)
+        return end();
+
+    int matched;
+    radix_burst_node<K, T> *node = locate(key, matched);
+    K suffix = radix_substr(key, matched, radix_length(key) - matched);
+
+    //内部节点的桶中只有空后缀
+    if (!node->m_children.empty() && radix_length(suffix) != 0)
+        return end();
+
+    iterator_entry it = lower_bound(node, suffix);
+    if (it == node->m_bucket.end() || !(it->first == suffix))
+        return end();
+    return iterator(node, it - node->m_bucket.begin());
+}
+
+template <typename K, typename T>
+typename radix_burst_tree<K, T>::iterator radix_burst_tree<K, T>::longest_match(const K &key)
+{
+    iterator best = end();
+    if (m_root == NULL)
+        return best;
+
+    int len = radix_length(key);
+    int matched = 0;
+    radix_burst_node<K, T> *node = m_root;
+    while (!node->m_children.empty())
+    {
+        if (!node->m_bucket.empty())
+            best = iterator(node, 0);
+        if (matched == len)
+            return best;
+
+        radix_burst_node<K, T> *child = find_child(node, key, matched);
+        if (child == NULL)
+            return best;
+        int len_child = radix_length(child->m_key);
+        if (common_prefix(child->m_key, 0, key, matched) < len_child)
+            return best;
+        node = child;
+        matched += len_child;
+    }
+
+    //桶中按序排列，同一序列的前缀中越长的越靠后
+    for (std::size_t i = 0; i < node->m_bucket.size(); i++)
+    {
+        const K &suffix = node->m_bucket[i].first;
+        int len_suffix = radix_length(suffix);
+        if (len_suffix <= len - matched && common_prefix(suffix, 0, key, matched) == len_suffix)
+            best = iterator(node, i);
+    }
+    return best;
+}
+
+template <typename K, typename T>
+void radix_burst_tree<K, T>::prefix_match(const K &key, std::vector<iterator> &vec)
+{
+    vec.clear();
+    if (m_root == NULL)
+        return;
+
+    int len = radix_length(key);
+    int matched = 0;
+    radix_burst_node<K, T> *node = m_root;
+    while (matched < len)
+    {
+        //在桶中查找以key剩余部分为前缀的连续区间
+        if (node->m_children.empty())
+        {
+            K rest = radix_substr(key, matched, len - matched);
+            int len_rest = len - matched;
+            iterator_entry it;
+            for (it = lower_bound(node, rest); it != node->m_bucket.end(); ++it)
+            {
+                if (radix_length(it->first) < len_rest || common_prefix(it->first, 0, rest, 0) < len_rest)
+                    break;
+                vec.push_back(iterator(node, it - node->m_bucket.begin()));
+            }
+            return;
+        }
+
+        radix_burst_node<K, T> *child = find_child(node, key, matched);
+        if (child == NULL)
+            return;
+        int len_child = radix_length(child->m_key);
+        int count = common_prefix(child->m_key, 0, key, matched);
+        //key在child的边上结束，child的整棵子树都以key为前缀
+        if (matched + count == len)
+        {
+            get_entries(child, vec);
+            return;
+        }
+        if (count < len_child)
+            return;
+        node = child;
+        matched += len_child;
+    }
+    get_entries(node, vec);
+}
+
+template <typename K, typename T>
+std::pair<typename radix_burst_tree<K, T>::iterator, bool> radix_burst_tree<K, T>::insert(const value_type &val)
+{
+    if (m_root == NULL)
+    {
+        m_root = new radix_burst_node<K, T>();
+        m_root->m_key = radix_substr(val.first, 0, 0);
+    }
+
+    int len = radix_length(val.first);
+    int matched;
+    radix_burst_node<K, T> *node = locate(val.first, matched);
+
+    //node为内部节点且val还有剩余部分时，需要新建子节点，必要时拆分已有的边
+    if (!node->m_children.empty() && matched < len)
+    {
+        radix_burst_node<K, T> *child = find_child(node, val.first, matched);
+        if (child != NULL)
+        {
+            //locate保证val在child的边上分叉或结束
+            int count = common_prefix(child->m_key, 0, val.first, matched);
+            node = split_node(child, count);
+            matched += count;
+        }
+        if (matched < len)
+        {
+            child = new radix_burst_node<K, T>();
+            child->m_key = radix_substr(val.first, matched, 1);
+            child->m_parent = node;
+            node->m_children[child->m_key] = child;
+            node = child;
+            matched++;
+        }
+    }
+
+    K suffix = radix_substr(val.first, matched, len - matched);
+    iterator_entry it = lower_bound(node, suffix);
+    if (it != node->m_bucket.end() && it->first == suffix)
+        return std::pair<iterator, bool>(iterator(node, it - node->m_bucket.begin()), false);
+
+    it = node->m_bucket.insert(it, entry_type(suffix, val.second));
+    m_size++;
+    if (node->m_children.empty() && node->m_bucket.size() > m_burst_size)
+    {
+        burst(node);
+        return std::pair<iterator, bool>(find(val.first), true);
+    }
+    return std::pair<iterator, bool>(iterator(node, it - node->m_bucket.begin()), true);
+}
+
+template <typename K, typename T>
+T &radix_burst_tree<K, T>::operator[](const K &key)
+{
+    iterator it = find(key);
+    if (it == end())
+    {
+        std::pair<K, T> val;
+        val.first = key;
+        it = insert(val).first;
+    }
+    return it->second;
+}
+
+template <typename K, typename T>
+void radix_burst_tree<K, T>::erase(iterator it)
+{
+    if (it == end())
+        return;
+
+    radix_burst_node<K, T> *node = it.m_node;
+    node->m_bucket.erase(node->m_bucket.begin() + it.m_index);
+    m_size--;
+    prune(node);
+}
+
+template <typename K, typename T>
+bool radix_burst_tree<K, T>::erase(const K &key)
+{
+    iterator it = find(key);
+    if (it == end())
+        return false;
+    erase(it);
+    return true;
+}
+
+template <typename K, typename T>
+radix_burst_node<K, T> *radix_burst_tree<K, T>::locate(const K &key, int &matched) const
+{
+    int len = radix_length(key);
+    radix_burst_node<K, T> *node = m_root;
+    matched = 0;
+    while (!node->m_children.empty() && matched < len)
+    {
+        radix_burst_node<K, T> *child = find_child(node, key, matched);
+        if (child == NULL)
+            break;
+        int len_child = radix_length(child->m_key);
+        if (common_prefix(child->m_key, 0, key, matched) < len_child)
+            break;
+        node = child;
+        matched += len_child;
+    }
+    return node;
+}
+
+template <typename K, typename T>
+radix_burst_node<K, T> *radix_burst_tree<K, T>::find_child(radix_burst_node<K, T> *node, const K &key, int pos)
+{
+    typename radix_burst_node<K, T>::iterator_child it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        if (it->first[0] == key[pos])
+            return it->second;
+    return NULL;
+}
+
+template <typename K, typename T>
+int radix_burst_tree<K, T>::common_prefix(const K &key1, int pos1, const K &key2, int pos2)
+{
+    int len1 = radix_length(key1) - pos1;
+    int len2 = radix_length(key2) - pos2;
+    int count = 0;
+    while (count < len1 && count < len2 && key1[pos1 + count] == key2[pos2 + count])
+        count++;
+    return count;
+}
+
+template <typename K, typename T>
+typename radix_burst_tree<K, T>::iterator_entry radix_burst_tree<K, T>::lower_bound(radix_burst_node<K, T> *node, const K &suffix)
+{
+    return std::lower_bound(node->m_bucket.begin(), node->m_bucket.end(), suffix, entry_less);
+}
+
+template <typename K, typename T>
+radix_burst_node<K, T> *radix_burst_tree<K, T>::split_node(radix_burst_node<K, T> *node, int count)
+{
+    int len = radix_length(node->m_key);
+    assert(count > 0 && count < len);
+
+    radix_burst_node<K, T> *parent = node->m_parent;
+    parent->m_children.erase(node->m_key);
+
+    radix_burst_node<K, T> *p = new radix_burst_node<K, T>();
+    p->m_key = radix_substr(node->m_key, 0, count);
+    p->m_parent = parent;
+    parent->m_children[p->m_key] = p;
+
+    node->m_key = radix_substr(node->m_key, count, len - count);
+    node->m_parent = p;
+    p->m_children[node->m_key] = node;
+    return p;
+}
+
+template <typename K, typename T>
+void radix_burst_tree<K, T>::burst(radix_burst_node<K, T> *node)
+{
+    assert(node->m_children.empty());
+
+    std::vector<entry_type> entries;
+    entries.swap(node->m_bucket);
+    iterator_entry it = entries.begin();
+
+    //空后缀排在最前，留在node中作为恰好在node结束的序列
+    if (radix_length(it->first) == 0)
+    {
+        node->m_bucket.push_back(*it);
+        ++it;
+    }
+
+    //桶中按序排列，首元素相同的后缀是连续的区间
+    while (it != entries.end())
+    {
+        iterator_entry last = it;
+        while (last + 1 != entries.end() && (last + 1)->first[0] == it->first[0])
+            ++last;
+
+        //有序区间的公共前缀等于首尾两个后缀的公共前缀
+        int count = common_prefix(it->first, 0, last->first, 0);
+        radix_burst_node<K, T> *child = new radix_burst_node<K, T>();
+        child->m_key = radix_substr(it->first, 0, count);
+        child->m_parent = node;
+        node->m_children[child->m_key] = child;
+
+        child->m_bucket.reserve(last - it + 1);
+        for (++last; it != last; ++it)
+            child->m_bucket.push_back(entry_type(radix_substr(it->first, count, radix_length(it->first) - count), it->second));
+
+        if (child->m_bucket.size() > m_burst_size)
+            burst(child);
+    }
+}
+
+template <typename K, typename T>
+void radix_burst_tree<K, T>::prune(radix_burst_node<K, T> *node)
+{
+    while (node != m_root)
+    {
+        radix_burst_node<K, T> *parent = node->m_parent;
+        if (node->m_bucket.empty() && node->m_children.empty())
+        {
+            parent->m_children.erase(node->m_key);
+            delete node;
+            node = parent;
+            continue;
+        }
+
+        //没有元素的内部节点只剩一个子节点时，将边合并到子节点
+        if (node->m_bucket.empty() && node->m_children.size() == 1)
+        {
+            radix_burst_node<K, T> *child = node->m_children.begin()->second;
+            parent->m_children.erase(node->m_key);
+            child->m_key = radix_join(node->m_key, child->m_key);
+            child->m_parent = parent;
+            parent->m_children[child->m_key] = child;
+            node->m_children.clear();
+            delete node;
+        }
+        return;
+    }
+}
+
+template <typename K, typename T>
+void radix_burst_tree<K, T>::get_entries(radix_burst_node<K, T> *node, std::vector<iterator> &vec)
+{
+    for (std::size_t i = 0; i < node->m_bucket.size(); i++)
+        vec.push_back(iterator(node, i));
+
+    typename radix_burst_node<K, T>::iterator_child it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        get_entries(it->second, vec);
+}
+#endif //RADIX_BURST_TREE
@@ -0,0 +1,612 @@
+#ifndef RADIX_COMPACT_TREE
+#define RADIX_COMPACT_TREE
+
+#include <vector>
+#include "radix_tree.h"
+#include "radix_value_store.h"
+
+template <typename K, typename T, typename Store = radix_value_store<T> > class radix_compact_tree;
+
+template <typename K, typename T, typename Store>
+class radix_compact_it : public std::iterator<std::forward_iterator_tag, std::pair<const K, T> >
+{
+    friend class radix_compact_tree<K, T, Store>;
+
+public:
+    typedef radix_pair_ref<K, typename Store::stored_type> reference;
+
+    //构造函数
+    radix_compact_it() : m_tree(NULL), m_node(0xffffffffu) {}
+
+    //重载运算符
+    /**
+     * @note 节点中不保存完整序列，解引用时沿冷数组中的父节点重建
+     */
+    reference operator*() const
+    {
+        return reference(m_tree->get_key(m_node), m_tree->get_value(m_node));
+    }
+
+    reference operator->() const
+    {
+        return **this;
+    }
+
+    radix_compact_it<K, T, Store> &operator++()
+    {
+        if (m_tree != NULL)
+            m_node = m_tree->next_value(m_node);
+        return *this;
+    }
+
+    radix_compact_it<K, T, Store> operator++(int)
+    {
+        radix_compact_it<K, T, Store> copy(*this);
+        ++(*this);
+        return copy;
+    }
+
+    bool operator!=(const radix_compact_it<K, T, Store> &r) const
+    {
+        return m_node != r.m_node;
+    }
+
+    bool operator==(const radix_compact_it<K, T, Store> &r) const
+    {
+        return m_node == r.m_node;
+    }
+
+private:
+    radix_compact_tree<K, T, Store> *m_tree;
+    unsigned int m_node;
+
+    radix_compact_it(radix_compact_tree<K, T, Store> *tree, unsigned int node) : m_tree(tree), m_node(node) {}
+};
+
+/**
+ * @brief 紧凑节点模式的基数树
+ * 节点保存在连续数组中，以32位下标代替指针互相引用，并按访问频率拆分为两个数组：
+ *  -热数组：查找时需要的边、首个子节点、下一个兄弟节点和值下标
+ *  -冷数组：只在迭代和删除时使用的父节点和深度
+ * 元素直接存放在其结束的节点中，不再单独建立叶子节点，节点只保存值在值存储中的下标，
+ * 完整序列不再重复保存，由迭代器沿路径重建。
+ * @note 删除的节点和值下标进入空闲链表复用；插入和删除会使指向被合并或拆分节点的迭代器失效
+ * @par Store 值存储，默认每个元素独占一个值；radix_interned_store使相等的值只保存一份
+ */
+template <typename K, typename T, typename Store>
+class radix_compact_tree
+{
+    friend class radix_compact_it<K, T, Store>;
+
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef radix_compact_it<K, T, Store> iterator;
+    typedef std::size_t size_type;
+    typedef unsigned int index_type;
+
+    //构造函数
+    radix_compact_tree() : m_size(0), m_hot(), m_cold(), m_store(), m_free_nodes() {}
+
+    /**
+     * @brief 按序复制tree中的所有元素
+     */
+    explicit radix_compact_tree(radix_tree<K, T> &tree) : m_size(0), m_hot(), m_cold(), m_store(), m_free_nodes()
+    {
+        typename radix_tree<K, T>::iterator it;
+        for (it = tree.begin(); it != tree.end(); ++it)
+            insert(*it);
+    }
+
+    //成员函数
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void clear()
+    {
+        m_hot.clear();
+        m_cold.clear();
+        m_store.clear();
+        m_free_nodes.clear();
+        m_size = 0;
+    }
+
+    /**
+     * @brief 节点数组中的节点个数，包括空闲节点
+     */
+    size_type node_count() const
+    {
+        return m_hot.size();
+    }
+
+    /**
+     * @brief 值存储，用于统计实际保存的值的个数
+     */
+    const Store &store() const
+    {
+        return m_store;
+    }
+
+    iterator begin();
+
+    iterator end()
+    {
+        return iterator(this, NPOS);
+    }
+
+    iterator find(const K &key);
+
+    /**
+     * @brief 寻找树中能够最长前缀匹配key的元素，若没有返回空迭代器
+     */
+    iterator longest_match(const K &key);
+
+    /**
+     * @brief 在树中寻找以key为前缀的所有元素，结果按序排列
+     * @par key 为空匹配树中所有元素
+     */
+    void prefix_match(const K &key, std::vector<iterator> &vec);
+
+    std::pair<iterator, bool> insert(const value_type &val);
+
+    typename Store::stored_type &operator[](const K &key);
+
+    /**
+     * @brief 插入或修改key对应的值
+     * @note 驻留存储中的值为常量，只能通过assign修改
+     */
+    iterator assign(const K &key, const T &value);
+
+    void erase(iterator it);
+
+    bool erase(const K &key);
+
+private:
+    static const index_type NPOS = 0xffffffffu;
+
+    /**
+     * @brief 查找路径上访问的字段，保持紧凑以便一个缓存行内容纳
+     * @note 兄弟节点按边的首元素有序排列
+     */
+    struct hot_node
+    {
+        K m_key;
+        index_type m_child;
+        index_type m_sibling;
+        index_type m_value;
+    };
+
+    /**
+     * @brief 查找时不访问的字段
+     * @note m_depth为m_key在完整序列中的起始下标
+     */
+    struct cold_node
+    {
+        index_type m_parent;
+        int m_depth;
+    };
+
+    size_type m_size;
+    std::vector<hot_node> m_hot;
+    std::vector<cold_node> m_cold;
+    Store m_store;
+    std::vector<index_type> m_free_nodes;
+
+    index_type new_node(const K &key, index_type parent, int depth);
+
+    void free_node(index_type node);
+
+    /**
+     * @brief 将child按首元素顺序插入parent的子节点链表
+     */
+    void link_child(index_type parent, index_type child);
+
+    /**
+     * @brief 在parent的子节点链表中用to替换from，位置不变
+     */
+    void replace_child(index_type parent, index_type from, index_type to);
+
+    /**
+     * @brief 在node的子节点中查找首元素等于key[pos]的节点
+     */
+    index_type find_child(index_type node, const K &key, int pos) const;
+
+    /**
+     * @brief 统计node的边与key从pos开始的公共前缀长度
+     */
+    int common_prefix(index_type node, const K &key, int pos) const;
+
+    /**
+     * @brief 沿key向下查找，返回路径是key前缀的最深节点
+     * @par matched 返回该节点末尾在key中的下标
+     */
+    index_type locate(const K &key, int &matched) const;
+
+    /**
+     * @brief 在node的前count个元素处将其拆分，公共前缀作为新的父节点
+     */
+    index_type split_node(index_type node, int count);
+
+    /**
+     * @brief 删除元素后维护树的性质：删除空节点，合并没有值且只有一个子节点的节点
+     */
+    void compress(index_type node);
+
+    /**
+     * @brief 按先序返回node之后首个有值的节点
+     */
+    index_type next_value(index_type node) const;
+
+    /**
+     * @brief 将node为根的子树中所有有值的节点按序添加到vec中
+     */
+    void get_values(index_type node, std::vector<iterator> &vec);
+
+    K get_key(index_type node) const;
+
+    typename Store::stored_type &get_value(index_type node)
+    {
+        return m_store.get(m_hot[node].m_value);
+    }
+};
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::iterator radix_compact_tree<K, T, Store>::begin()
+{
+    if (m_size == 0)
+        return end();
+    if (m_hot[0].m_value != NPOS)
+        return iterator(this, 0);
+    return iterator(this, next_value(0));
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::iterator radix_compact_tree<K, T, Store>::find(const K &key)
+{
+    if (m_hot.empty())
+        return end();
+
+    int matched;
+    index_type node = locate(key, matched);
+    if (matched != radix_length(key) || m_hot[node].m_value == NPOS)
+        return end();
+    return iterator(this, node);
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::iterator radix_compact_tree<K, T, Store>::longest_match(const K &key)
+{
+    if (m_hot.empty())
+        return end();
+
+    int len = radix_length(key);
+    int matched = 0;
+    index_type node = 0;
+    index_type best = NPOS;
+    while (true)
+    {
+        if (m_hot[node].m_value != NPOS)
+            best = node;
+        if (matched == len)
+            break;
+        index_type child = find_child(node, key, matched);
+        if (child == NPOS)
+            break;
+        int len_child = radix_length(m_hot[child].m_key);
+        if (common_prefix(child, key, matched) < len_child)
+            break;
+        node = child;
+        matched += len_child;
+    }
+    return iterator(this, best);
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::prefix_match(const K &key, std::vector<iterator> &vec)
+{
+    vec.clear();
+    if (m_hot.empty())
+        return;
+
+    int len = radix_length(key);
+    int matched;
+    index_type node = locate(key, matched);
+    if (matched < len)
+    {
+        //key在子节点的边上结束时，该子节点的整棵子树都以key为前缀
+        index_type child = find_child(node, key, matched);
+        if (child == NPOS || matched + common_prefix(child, key, matched) != len)
+            return;
+        node = child;
+    }
+    get_values(node, vec);
+}
+
+template <typename K, typename T, typename Store>
+std::pair<typename radix_compact_tree<K, T, Store>::iterator, bool> radix_compact_tree<K, T, Store>::insert(const value_type &val)
+{
+    if (m_hot.empty())
+        new_node(radix_substr(val.first, 0, 0), NPOS, 0);
+
+    int len = radix_length(val.first);
+    int matched;
+    index_type node = locate(val.first, matched);
+
+    if (matched < len)
+    {
+        index_type child = find_child(node, val.first, matched);
+        if (child != NPOS)
+        {
+            //val在child的边上分叉或结束
+            int count = common_prefix(child, val.first, matched);
+            node = split_node(child, count);
+            matched += count;
+        }
+        if (matched < len)
+        {
+            index_type leaf = new_node(radix_substr(val.first, matched, len - matched), node, matched);
+            link_child(node, leaf);
+            node = leaf;
+        }
+    }
+    else if (m_hot[node].m_value != NPOS)
+    {
+        return std::pair<iterator, bool>(iterator(this, node), false);
+    }
+
+    index_type value = m_store.add(val.second);
+    m_hot[node].m_value = value;
+    m_size++;
+    return std::pair<iterator, bool>(iterator(this, node), true);
+}
+
+template <typename K, typename T, typename Store>
+typename Store::stored_type &radix_compact_tree<K, T, Store>::operator[](const K &key)
+{
+    iterator it = find(key);
+    if (it == end())
+    {
+        std::pair<K, T> val;
+        val.first = key;
+        it = insert(val).first;
+    }
+    return get_value(it.m_node);
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::iterator radix_compact_tree<K, T, Store>::assign(const K &key, const T &value)
+{
+    std::pair<iterator, bool> ret = insert(value_type(key, value));
+    if (!ret.second)
+    {
+        index_type node = ret.first.m_node;
+        m_hot[node].m_value = m_store.assign(m_hot[node].m_value, value);
+    }
+    return ret.first;
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::erase(iterator it)
+{
+    if (it == end())
+        return;
+
+    index_type node = it.m_node;
+    m_store.remove(m_hot[node].m_value);
+    m_hot[node].m_value = NPOS;
+    m_size--;
+    compress(node);
+}
+
+template <typename K, typename T, typename Store>
+bool radix_compact_tree<K, T, Store>::erase(const K &key)
+{
+    iterator it = find(key);
+    if (it == end())
+        return false;
+    erase(it);
+    return true;
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::index_type radix_compact_tree<K, T, Store>::new_node(const K &key, index_type parent, int depth)
+{
+    index_type node;
+    if (m_free_nodes.empty())
+    {
+        node = m_hot.size();
+        m_hot.push_back(hot_node());
+        m_cold.push_back(cold_node());
+    }
+    else
+    {
+        node = m_free_nodes.back();
+        m_free_nodes.pop_back();
+    }
+
+    m_hot[node].m_key = key;
+    m_hot[node].m_child = NPOS;
+    m_hot[node].m_sibling = NPOS;
+    m_hot[node].m_value = NPOS;
+    m_cold[node].m_parent = parent;
+    m_cold[node].m_depth = depth;
+    return node;
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::free_node(index_type node)
+{
+    m_hot[node].m_key = K();
+    m_cold[node].m_parent = NPOS;
+    m_free_nodes.push_back(node);
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::link_child(index_type parent, index_type child)
+{
+    index_type *link = &m_hot[parent].m_child;
+    while (*link != NPOS && m_hot[*link].m_key < m_hot[child].m_key)
+        link = &m_hot[*link].m_sibling;
+    m_hot[child].m_sibling = *link;
+    *link = child;
+    m_cold[child].m_parent = parent;
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::replace_child(index_type parent, index_type from, index_type to)
+{
+    index_type *link = &m_hot[parent].m_child;
+    while (*link != from)
+        link = &m_hot[*link].m_sibling;
+    m_hot[to].m_sibling = m_hot[from].m_sibling;
+    *link = to;
+    m_cold[to].m_parent = parent;
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::index_type radix_compact_tree<K, T, Store>::find_child(index_type node, const K &key, int pos) const
+{
+    index_type child;
+    for (child = m_hot[node].m_child; child != NPOS; child = m_hot[child].m_sibling)
+        if (m_hot[child].m_key[0] == key[pos])
+            return child;
+    return NPOS;
+}
+
+template <typename K, typename T, typename Store>
+int radix_compact_tree<K, T, Store>::common_prefix(index_type node, const K &key, int pos) const
+{
+    const K &edge = m_hot[node].m_key;
+    int len1 = radix_length(edge);
+    int len2 = radix_length(key) - pos;
+    int count = 0;
+    while (count < len1 && count < len2 && edge[count] == key[pos + count])
+        count++;
+    return count;
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::index_type radix_compact_tree<K, T, Store>::locate(const K &key, int &matched) const
+{
+    int len = radix_length(key);
+    index_type node = 0;
+    matched = 0;
+    while (matched < len)
+    {
+        index_type child = find_child(node, key, matched);
+        if (child == NPOS)
+            break;
+        int len_child = radix_length(m_hot[child].m_key);
+        if (common_prefix(child, key, matched) < len_child)
+            break;
+        node = child;
+        matched += len_child;
+    }
+    return node;
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::index_type radix_compact_tree<K, T, Store>::split_node(index_type node, int count)
+{
+    int len = radix_length(m_hot[node].m_key);
+    assert(count > 0 && count < len);
+
+    //new_node可能使数组重新分配，先复制需要的字段
+    index_type parent = m_cold[node].m_parent;
+    int depth = m_cold[node].m_depth;
+    K key = m_hot[node].m_key;
+
+    index_type p = new_node(radix_substr(key, 0, count), parent, depth);
+    replace_child(parent, node, p);
+
+    m_hot[node].m_key = radix_substr(key, count, len - count);
+    m_hot[node].m_sibling = NPOS;
+    m_hot[p].m_child = node;
+    m_cold[node].m_parent = p;
+    m_cold[node].m_depth = depth + count;
+    return p;
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::compress(index_type node)
+{
+    while (node != 0 && m_hot[node].m_value == NPOS)
+    {
+        index_type parent = m_cold[node].m_parent;
+        index_type child = m_hot[node].m_child;
+
+        //没有值也没有子节点，从父节点中移除后继续检查父节点
+        if (child == NPOS)
+        {
+            index_type *link = &m_hot[parent].m_child;
+            while (*link != node)
+                link = &m_hot[*link].m_sibling;
+            *link = m_hot[node].m_sibling;
+            free_node(node);
+            node = parent;
+            continue;
+        }
+
+        //没有值且只有一个子节点，将边合并到子节点，由子节点取代node
+        if (m_hot[child].m_sibling == NPOS)
+        {
+            m_hot[child].m_key = radix_join(m_hot[node].m_key, m_hot[child].m_key);
+            m_cold[child].m_depth = m_cold[node].m_depth;
+            replace_child(parent, node, child);
+            free_node(node);
+        }
+        return;
+    }
+}
+
+template <typename K, typename T, typename Store>
+typename radix_compact_tree<K, T, Store>::index_type radix_compact_tree<K, T, Store>::next_value(index_type node) const
+{
+    while (true)
+    {
+        //先序遍历：先进入子节点，没有子节点时寻找自身或祖先的下一个兄弟节点
+        if (m_hot[node].m_child != NPOS)
+            node = m_hot[node].m_child;
+        else
+        {
+            while (m_hot[node].m_sibling == NPOS)
+            {
+                node = m_cold[node].m_parent;
+                if (node == NPOS)
+                    return NPOS;
+            }
+            node = m_hot[node].m_sibling;
+        }
+        if (m_hot[node].m_value != NPOS)
+            return node;
+    }
+}
+
+template <typename K, typename T, typename Store>
+void radix_compact_tree<K, T, Store>::get_values(index_type node, std::vector<iterator> &vec)
+{
+    if (m_hot[node].m_value != NPOS)
+        vec.push_back(iterator(this, node));
+
+    index_type child;
+    for (child = m_hot[node].m_child; child != NPOS; child = m_hot[child].m_sibling)
+        get_values(child, vec);
+}
+
+template <typename K, typename T, typename Store>
+K radix_compact_tree<K, T, Store>::get_key(index_type node) const
+{
+    K key = m_hot[node].m_key;
+    for (node = m_cold[node].m_parent; node != NPOS; node = m_cold[node].m_parent)
+        key = radix_join(m_hot[node].m_key, key);
+    return key;
+}
+#endif //RADIX_COMPACT_TREE
@@ -0,0 +1,139 @@
+#ifndef RADIX_LOOKUP_CACHE
+#define RADIX_LOOKUP_CACHE
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "radix_tree.h"
+
+/**
+ * @brief radix_tree::longest_match前的组相联查找结果缓存
+ * 以完整的查找序列为键缓存匹配结果（包括匹配失败），树的结构版本号变化时旧结果全部失效，
+ * 失效只需比较版本号，不需要清空缓存。组内按最近使用排序，未命中时优先覆盖同一序列或已失效的项，
+ * 都没有时才替换最久未使用的一项。
+ * @note 缓存本身不加锁，每个线程持有自己的实例；与树的修改并发时仍需由调用方同步树本身。
+ *  缓存的是迭代器，值的原地修改无需失效即可见。
+ * @par Hash 序列的哈希函数，默认为std::hash<K>
+ */
+template <typename K, typename T, typename Hash = std::hash<K> >
+class radix_lookup_cache
+{
+public:
+    typedef radix_tree<K, T> tree_type;
+    typedef typename tree_type::iterator iterator;
+    typedef std::size_t size_type;
+
+    //构造函数
+    /**
+     * @par sets 组数，向上取整为2的幂
+     * @par ways 每组的项数，需要大于0
+     */
+    explicit radix_lookup_cache(tree_type &tree, size_type sets = 1024, size_type ways = 4, const Hash &hash = Hash());
+
+    //成员函数
+    /**
+     * @brief 与tree.longest_match(key)结果相同，命中时不访问树的节点
+     */
+    iterator longest_match(const K &key);
+
+    /**
+     * @brief 清空缓存的结果，不影响命中统计
+     */
+    void clear();
+
+    size_type hits() const
+    {
+        return m_hits;
+    }
+
+    size_type misses() const
+    {
+        return m_misses;
+    }
+
+    void reset_stats()
+    {
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+private:
+    struct entry
+    {
+        K m_key;
+        iterator m_result;
+        unsigned long m_generation;
+        bool m_valid;
+
+        entry() : m_key(), m_result(), m_generation(0), m_valid(false) {}
+    };
+
+    tree_type &m_tree;
+    Hash m_hash;
+    size_type m_mask;
+    size_type m_ways;
+    std::vector<entry> m_entries;
+    size_type m_hits;
+    size_type m_misses;
+};
+
+template <typename K, typename T, typename Hash>
+radix_lookup_cache<K, T, Hash>::radix_lookup_cache(tree_type &tree, size_type sets, size_type ways, const Hash &hash)
+    : m_tree(tree), m_hash(hash), m_mask(0), m_ways(ways), m_entries(), m_hits(0), m_misses(0)
+{
+    assert(ways > 0);
+    size_type n = 1;
+    while (n < sets)
+        n <<= 1;
+    m_mask = n - 1;
+    m_entries.resize(n * ways);
+}
+
+template <typename K, typename T, typename Hash>
+typename radix_lookup_cache<K, T, Hash>::iterator radix_lookup_cache<K, T, Hash>::longest_match(const K &key)
+{
+    unsigned long generation = m_tree.generation();
+    typename std::vector<entry>::iterator set = m_entries.begin() + (m_hash(key) & m_mask) * m_ways;
+
+    //每个序列在组内至多一项：同一序列的旧结果直接覆盖，否则覆盖最久未使用的失效项，都没有时才淘汰组尾
+    size_type victim = m_ways;
+    size_type stale = m_ways;
+    for (size_type i = 0; i < m_ways; i++)
+    {
+        entry &e = set[i];
+        bool live = e.m_valid && e.m_generation == generation;
+        if (e.m_valid && e.m_key == key)
+        {
+            victim = i;
+            if (live)
+            {
+                //命中项移到组首
+                std::rotate(set, set + i, set + i + 1);
+                m_hits++;
+                return set[0].m_result;
+            }
+            break;
+        }
+        if (!live)
+            stale = i;
+    }
+
+    m_misses++;
+    if (victim == m_ways)
+        victim = stale != m_ways ? stale : m_ways - 1;
+    std::rotate(set, set + victim, set + victim + 1);
+    set[0].m_key = key;
+    set[0].m_result = m_tree.longest_match(key);
+    set[0].m_generation = generation;
+    set[0].m_valid = true;
+    return set[0].m_result;
+}
+
+template <typename K, typename T, typename Hash>
+void radix_lookup_cache<K, T, Hash>::clear()
+{
+    typename std::vector<entry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it)
+        it->m_valid = false;
+}
+#endif //RADIX_LOOKUP_CACHE
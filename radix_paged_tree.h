@@ -0,0 +1,1078 @@
+#ifndef RADIX_PAGED_TREE
+#define RADIX_PAGED_TREE
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "radix_serialize.h"
+
+/**
+ * @brief 定长页文件的缓冲池
+ * 最多在内存中保留frames个页，缺页时按CLOCK策略淘汰未被固定的页，脏页在淘汰或flush时写回。
+ * @note 不是线程安全的
+ */
+class radix_page_pool
+{
+public:
+    typedef std::size_t size_type;
+
+    static const size_type PAGE_SIZE = 4096;
+
+    //构造函数
+    explicit radix_page_pool(size_type frames = 256)
+        : m_fd(-1), m_good(true), m_pages(0), m_data(frames * PAGE_SIZE), m_frames(frames), m_table(), m_hand(0),
+          m_reads(0), m_writes(0)
+    {
+        assert(frames > 0);
+    }
+
+    ~radix_page_pool()
+    {
+        close();
+    }
+
+    //成员函数
+    /**
+     * @brief 打开页文件，不存在时创建
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief 写回所有脏页并关闭文件
+     */
+    bool close();
+
+    /**
+     * @brief 写回所有脏页并落盘
+     */
+    bool flush();
+
+    bool is_open() const
+    {
+        return m_fd >= 0;
+    }
+
+    /**
+     * @brief 之前的读写是否都成功
+     */
+    bool good() const
+    {
+        return m_good;
+    }
+
+    /**
+     * @brief 返回页id的内容并将其固定在缓冲池中，直到对应的unpin
+     * @note 所有页都被固定时返回NULL
+     */
+    char *pin(uint32_t id);
+
+    /**
+     * @par dirty 页的内容是否被修改
+     */
+    void unpin(uint32_t id, bool dirty);
+
+    /**
+     * @brief 在文件末尾新增一页，内容全为0
+     */
+    uint32_t extend();
+
+    uint32_t page_count() const
+    {
+        return m_pages;
+    }
+
+    /**
+     * @brief 从文件读取和写入的页数
+     */
+    size_type reads() const
+    {
+        return m_reads;
+    }
+
+    size_type writes() const
+    {
+        return m_writes;
+    }
+
+private:
+    struct frame
+    {
+        uint32_t m_id;
+        int m_pin;
+        bool m_ref;
+        bool m_dirty;
+        bool m_used;
+
+        frame() : m_id(0), m_pin(0), m_ref(false), m_dirty(false), m_used(false) {}
+    };
+
+    int m_fd;
+    bool m_good;
+    uint32_t m_pages;
+    std::vector<char> m_data;
+    std::vector<frame> m_frames;
+    std::map<uint32_t, size_type> m_table;
+    size_type m_hand;
+    size_type m_reads;
+    size_type m_writes;
+
+    radix_page_pool(const radix_page_pool &);
+    radix_page_pool &operator=(const radix_page_pool &);
+
+    /**
+     * @brief CLOCK：跳过被固定的页，清除访问位后第二次经过时淘汰
+     * @return 可用的帧，全部被固定时返回-1
+     */
+    long victim();
+
+    bool write_frame(size_type f);
+};
+
+inline bool radix_page_pool::open(const std::string &path)
+{
+    if (m_fd >= 0)
+        return false;
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_pages = st.st_size / PAGE_SIZE;
+    m_good = true;
+    return true;
+}
+
+inline bool radix_page_pool::close()
+{
+    if (m_fd < 0)
+        return true;
+    bool ok = flush();
+    ::close(m_fd);
+    m_fd = -1;
+    m_table.clear();
+    m_frames.assign(m_frames.size(), frame());
+    return ok;
+}
+
+inline bool radix_page_pool::flush()
+{
+    for (size_type f = 0; f < m_frames.size(); f++)
+        if (m_frames[f].m_used && m_frames[f].m_dirty)
+            write_frame(f);
+    if (m_fd >= 0 && fdatasync(m_fd) != 0)
+        m_good = false;
+    return m_good;
+}
+
+inline char *radix_page_pool::pin(uint32_t id)
+{
+    std::map<uint32_t, size_type>::iterator it = m_table.find(id);
+    if (it != m_table.end())
+    {
+        frame &fr = m_frames[it->second];
+        fr.m_pin++;
+        fr.m_ref = true;
+        return &m_data[it->second * PAGE_SIZE];
+    }
+
+    long v = victim();
+    if (v < 0)
+        return NULL;
+    size_type f = v;
+    if (m_frames[f].m_used)
+    {
+        if (m_frames[f].m_dirty)
+            write_frame(f);
+        m_table.erase(m_frames[f].m_id);
+    }
+
+    //文件末尾之后的部分视为0
+    char *data = &m_data[f * PAGE_SIZE];
+    ssize_t n = pread(m_fd, data, PAGE_SIZE, static_cast<off_t>(id) * PAGE_SIZE);
+    if (n < 0)
+    {
+        m_good = false;
+        n = 0;
+    }
+    if (n > 0)
+        m_reads++;
+    memset(data + n, 0, PAGE_SIZE - n);
+
+    frame &fr = m_frames[f];
+    fr.m_id = id;
+    fr.m_pin = 1;
+    fr.m_ref = true;
+    fr.m_dirty = false;
+    fr.m_used = true;
+    m_table[id] = f;
+    return data;
+}
+
+inline void radix_page_pool::unpin(uint32_t id, bool dirty)
+{
+    std::map<uint32_t, size_type>::iterator it = m_table.find(id);
+    assert(it != m_table.end());
+    frame &fr = m_frames[it->second];
+    assert(fr.m_pin > 0);
+    fr.m_pin--;
+    if (dirty)
+        fr.m_dirty = true;
+}
+
+inline uint32_t radix_page_pool::extend()
+{
+    uint32_t id = m_pages++;
+    char *data = pin(id);
+    if (data != NULL)
+    {
+        memset(data, 0, PAGE_SIZE);
+        unpin(id, true);
+    }
+    return id;
+}
+
+inline long radix_page_pool::victim()
+{
+    for (size_type i = 0; i < 2 * m_frames.size(); i++)
+    {
+        size_type f = m_hand;
+        m_hand = (m_hand + 1) % m_frames.size();
+        frame &fr = m_frames[f];
+        if (!fr.m_used)
+            return f;
+        if (fr.m_pin > 0)
+            continue;
+        if (fr.m_ref)
+        {
+            fr.m_ref = false;
+            continue;
+        }
+        return f;
+    }
+    return -1;
+}
+
+inline bool radix_page_pool::write_frame(size_type f)
+{
+    ssize_t n = pwrite(m_fd, &m_data[f * PAGE_SIZE], PAGE_SIZE, static_cast<off_t>(m_frames[f].m_id) * PAGE_SIZE);
+    if (n != static_cast<ssize_t>(PAGE_SIZE))
+    {
+        m_good = false;
+        return false;
+    }
+    m_writes++;
+    m_frames[f].m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 存储在页文件中的字符串基数树（B-trie/HAT-trie风格），容量不受内存限制
+ * 文件由定长页组成，页0为文件头，其余页有两种：
+ *  -trie页：一段压缩的边（前缀）、恰好在前缀末尾结束的元素，以及按下一个字节索引的256个子页
+ *  -容器页：有序存放的（后缀，值）对及其偏移目录，页满时分裂（burst）为一个trie页，以所有后缀的
+ *   公共前缀作为边，按其后的字节分组到新的容器页
+ * 每次操作从根沿trie页下降，最多读取（trie页层数 + 1）个页；查找直接在缓冲池的页上进行，
+ * 容器页按偏移目录二分查找，不解码整页。前缀查找对子树中的每个页只按序读取一次；
+ * 分裂产生的页追加在文件末尾，顺序与前缀查找的访问顺序一致，之后插入新建的页从空闲页复用，
+ * 可能不再连续。所有页都通过有界的缓冲池访问。
+ * @note 值通过radix_serialize/radix_deserialize存储，单个元素序列化后不能超过MAX_ENTRY字节
+ * @note 不是线程安全的；close或flush之前崩溃时，文件内容可能不一致
+ */
+template <typename T>
+class radix_paged_tree
+{
+public:
+    typedef std::string key_type;
+    typedef T mapped_type;
+    typedef std::pair<const std::string, T> value_type;
+    typedef std::size_t size_type;
+
+    static const size_type MAX_ENTRY = 2040;
+
+    //构造函数
+    /**
+     * @par frames 缓冲池中的页数
+     */
+    explicit radix_paged_tree(size_type frames = 256) : m_pool(frames), m_size(0), m_root(0), m_free(0) {}
+
+    ~radix_paged_tree()
+    {
+        close();
+    }
+
+    //成员函数
+    /**
+     * @brief 打开或创建页文件
+     * @return 文件不是有效的页文件或无法打开时返回false
+     */
+    bool open(const std::string &path);
+
+    bool close();
+
+    /**
+     * @brief 写回文件头和所有脏页并落盘
+     */
+    bool flush();
+
+    bool good() const
+    {
+        return m_pool.good();
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    const radix_page_pool &pool() const
+    {
+        return m_pool;
+    }
+
+    /**
+     * @brief 查找key，找到时将值写入value
+     */
+    bool find(const std::string &key, T &value);
+
+    /**
+     * @brief 寻找能够最长前缀匹配key的元素
+     * @par match 匹配到的序列
+     */
+    bool longest_match(const std::string &key, std::string &match, T &value);
+
+    /**
+     * @brief 按序返回以key为前缀的所有元素
+     */
+    void prefix_match(const std::string &key, std::vector<std::pair<std::string, T> > &vec);
+
+    /**
+     * @return 已存在或元素过大时返回false
+     */
+    bool insert(const value_type &val);
+
+    bool erase(const std::string &key);
+
+private:
+    enum page_type
+    {
+        TRIE_PAGE = 1,
+        CONTAINER_PAGE = 2,
+        FREE_PAGE = 3
+    };
+
+    static const uint32_t MAGIC = 0x50584452;
+    static const size_type MAX_PREFIX = 1024;
+    //trie页：类型、是否有值、前缀长度、值长度各占2字节，之后为256个子页号、前缀和值
+    static const size_type TRIE_HEADER = 8 + 256 * sizeof(uint32_t);
+    //容器页：类型和元素个数，之后为每个元素在页中的偏移（各2字节），每个元素为后缀长度、值长度、后缀和值
+    static const size_type CONTAINER_HEADER = 4;
+
+    typedef std::vector<std::pair<std::string, std::string> > entries_type;
+
+    struct trie_page
+    {
+        std::string m_prefix;
+        bool m_has_value;
+        std::string m_value;
+        uint32_t m_child[256];
+
+        trie_page() : m_prefix(), m_has_value(false), m_value()
+        {
+            memset(m_child, 0, sizeof(m_child));
+        }
+
+        bool empty() const
+        {
+            if (m_has_value)
+                return false;
+            for (int i = 0; i < 256; i++)
+                if (m_child[i] != 0)
+                    return false;
+            return true;
+        }
+    };
+
+    radix_page_pool m_pool;
+    size_type m_size;
+    uint32_t m_root;
+    uint32_t m_free;
+
+    /**
+     * @brief 读取页id，返回页的类型
+     */
+    int load(uint32_t id, trie_page &trie, entries_type &entries);
+
+    void store_trie(uint32_t id, const trie_page &trie);
+
+    void store_container(uint32_t id, const entries_type &entries);
+
+    /**
+     * @brief 将有序的entries写入页id，超过一页时分裂为trie页和若干容器页
+     */
+    void store_entries(uint32_t id, const entries_type &entries);
+
+    void store_header();
+
+    uint32_t allocate();
+
+    void release(uint32_t id);
+
+    /**
+     * @brief 在父trie页中依次移除path记录的子页，直到父页非空
+     */
+    void unlink(std::vector<std::pair<uint32_t, unsigned char> > &path);
+
+    /**
+     * @brief 将页id为根的子树中的所有元素按序添加到vec中
+     * @par path 到达页id之前已经消耗的序列
+     */
+    void collect(uint32_t id, const std::string &path, std::vector<std::pair<std::string, T> > &vec);
+
+    static size_type container_size(const entries_type &entries);
+
+    static bool entry_less(const std::pair<std::string, std::string> &a, const std::pair<std::string, std::string> &b)
+    {
+        return a.first < b.first;
+    }
+
+    static size_type common_prefix(const std::string &a, const std::string &key, size_type pos)
+    {
+        size_type count = 0;
+        while (count < a.size() && pos + count < key.size() && a[count] == key[pos + count])
+            count++;
+        return count;
+    }
+
+    /**
+     * @note 页中的值都由radix_serialize写入，反序列化失败说明页已损坏
+     */
+    static T decode(const char *data, size_type len)
+    {
+        T value = T();
+        bool ok = radix_deserialize(data, data + len, value);
+        assert(ok);
+        (void)ok;
+        return value;
+    }
+
+    static T decode(const std::string &data)
+    {
+        return decode(data.data(), data.size());
+    }
+
+    /**
+     * @note 以下函数直接读取缓冲池中固定的页，调用方负责pin和unpin
+     */
+    static uint32_t trie_child(const char *p, unsigned char c)
+    {
+        uint32_t id;
+        memcpy(&id, p + 8 + c * sizeof(uint32_t), sizeof(id));
+        return id;
+    }
+
+    static T trie_value(const char *p)
+    {
+        return decode(p + TRIE_HEADER + get16(p + 2), get16(p + 4));
+    }
+
+    static const char *container_entry(const char *p, size_type i)
+    {
+        return p + get16(p + CONTAINER_HEADER + 2 * i);
+    }
+
+    static T entry_value(const char *entry)
+    {
+        return decode(entry + 4 + get16(entry), get16(entry + 2));
+    }
+
+    /**
+     * @brief 比较元素的后缀与序列[s, s + len)
+     */
+    static int compare_entry(const char *entry, const char *s, size_type len)
+    {
+        size_type len_suffix = get16(entry);
+        int cmp = memcmp(entry + 4, s, std::min(len_suffix, len));
+        if (cmp != 0)
+            return cmp;
+        return len_suffix < len ? -1 : (len_suffix > len ? 1 : 0);
+    }
+
+    /**
+     * @brief 容器页p中首个后缀不小于（upper为true时大于）[s, s + len)的元素下标
+     */
+    static size_type search_container(const char *p, const char *s, size_type len, bool upper);
+
+    static void put16(char *p, size_type v)
+    {
+        uint16_t x = static_cast<uint16_t>(v);
+        memcpy(p, &x, sizeof(x));
+    }
+
+    static size_type get16(const char *p)
+    {
+        uint16_t x;
+        memcpy(&x, p, sizeof(x));
+        return x;
+    }
+};
+
+template <typename T>
+bool radix_paged_tree<T>::open(const std::string &path)
+{
+    if (m_pool.is_open() || !m_pool.open(path))
+        return false;
+
+    if (m_pool.page_count() == 0)
+    {
+        //新文件：文件头和空的根容器页
+        m_pool.extend();
+        m_root = m_pool.extend();
+        m_free = 0;
+        m_size = 0;
+        store_container(m_root, entries_type());
+        store_header();
+        return m_pool.good();
+    }
+
+    const char *p = m_pool.pin(0);
+    uint32_t magic;
+    uint64_t size;
+    memcpy(&magic, p, sizeof(magic));
+    memcpy(&m_root, p + 4, sizeof(m_root));
+    memcpy(&m_free, p + 8, sizeof(m_free));
+    memcpy(&size, p + 12, sizeof(size));
+    m_pool.unpin(0, false);
+    if (magic != MAGIC)
+    {
+        m_pool.close();
+        return false;
+    }
+    m_size = size;
+    return m_pool.good();
+}
+
+template <typename T>
+bool radix_paged_tree<T>::close()
+{
+    if (!m_pool.is_open())
+        return true;
+    store_header();
+    return m_pool.close();
+}
+
+template <typename T>
+bool radix_paged_tree<T>::flush()
+{
+    store_header();
+    return m_pool.flush();
+}
+
+template <typename T>
+bool radix_paged_tree<T>::find(const std::string &key, T &value)
+{
+    uint32_t id = m_root;
+    size_type pos = 0;
+    while (true)
+    {
+        const char *p = m_pool.pin(id);
+        bool found = false;
+        uint32_t next = 0;
+        if (p[0] == CONTAINER_PAGE)
+        {
+            size_type i = search_container(p, key.data() + pos, key.size() - pos, false);
+            if (i < get16(p + 2) && compare_entry(container_entry(p, i), key.data() + pos, key.size() - pos) == 0)
+            {
+                found = true;
+                value = entry_value(container_entry(p, i));
+            }
+        }
+        else
+        {
+            size_type len_prefix = get16(p + 2);
+            if (key.compare(pos, len_prefix, p + TRIE_HEADER, len_prefix) == 0)
+            {
+                pos += len_prefix;
+                if (pos == key.size())
+                {
+                    found = p[1] != 0;
+                    if (found)
+                        value = trie_value(p);
+                }
+                else
+                    next = trie_child(p, static_cast<unsigned char>(key[pos++]));
+            }
+        }
+        m_pool.unpin(id, false);
+        if (next == 0)
+            return found;
+        id = next;
+    }
+}
+
+template <typename T>
+bool radix_paged_tree<T>::longest_match(const std::string &key, std::string &match, T &value)
+{
+    uint32_t id = m_root;
+    size_type pos = 0;
+    size_type best_len = 0;
+    bool found = false;
+    while (true)
+    {
+        const char *p = m_pool.pin(id);
+        uint32_t next = 0;
+        if (p[0] == CONTAINER_PAGE)
+        {
+            //limit之内最后一个不大于剩余序列的后缀若不是其前缀，与剩余序列的公共前缀长度l之后
+            //不存在更长的匹配，在[pos, pos + l)中继续查找
+            size_type limit = key.size() - pos;
+            while (true)
+            {
+                size_type i = search_container(p, key.data() + pos, limit, true);
+                if (i == 0)
+                    break;
+                const char *entry = container_entry(p, i - 1);
+                size_type len_suffix = get16(entry);
+                size_type l = 0;
+                while (l < len_suffix && l < limit && entry[4 + l] == key[pos + l])
+                    l++;
+                if (l == len_suffix)
+                {
+                    found = true;
+                    best_len = pos + len_suffix;
+                    value = entry_value(entry);
+                    break;
+                }
+                limit = l;
+            }
+        }
+        else
+        {
+            size_type len_prefix = get16(p + 2);
+            if (key.compare(pos, len_prefix, p + TRIE_HEADER, len_prefix) == 0)
+            {
+                pos += len_prefix;
+                if (p[1] != 0)
+                {
+                    found = true;
+                    best_len = pos;
+                    value = trie_value(p);
+                }
+                if (pos < key.size())
+                    next = trie_child(p, static_cast<unsigned char>(key[pos]));
+            }
+        }
+        m_pool.unpin(id, false);
+        if (next == 0)
+            break;
+        pos++;
+        id = next;
+    }
+
+    if (found)
+        match = key.substr(0, best_len);
+    return found;
+}
+
+template <typename T>
+void radix_paged_tree<T>::prefix_match(const std::string &key, std::vector<std::pair<std::string, T> > &vec)
+{
+    vec.clear();
+    uint32_t id = m_root;
+    size_type pos = 0;
+    while (true)
+    {
+        const char *p = m_pool.pin(id);
+        size_type rest = key.size() - pos;
+        if (p[0] == CONTAINER_PAGE)
+        {
+            std::string path = key.substr(0, pos);
+            size_type count = get16(p + 2);
+            for (size_type i = search_container(p, key.data() + pos, rest, false); i < count; i++)
+            {
+                const char *entry = container_entry(p, i);
+                size_type len_suffix = get16(entry);
+                if (len_suffix < rest || memcmp(entry + 4, key.data() + pos, rest) != 0)
+                    break;
+                vec.push_back(std::pair<std::string, T>(path + std::string(entry + 4, len_suffix), entry_value(entry)));
+            }
+            m_pool.unpin(id, false);
+            return;
+        }
+
+        size_type len_prefix = get16(p + 2);
+        if (rest <= len_prefix)
+        {
+            //key在边上结束，整棵子树都以key为前缀
+            bool all = memcmp(p + TRIE_HEADER, key.data() + pos, rest) == 0;
+            m_pool.unpin(id, false);
+            if (all)
+                collect(id, key.substr(0, pos), vec);
+            return;
+        }
+        uint32_t next = 0;
+        if (memcmp(p + TRIE_HEADER, key.data() + pos, len_prefix) == 0)
+        {
+            pos += len_prefix;
+            next = trie_child(p, static_cast<unsigned char>(key[pos++]));
+        }
+        m_pool.unpin(id, false);
+        if (next == 0)
+            return;
+        id = next;
+    }
+}
+
+template <typename T>
+bool radix_paged_tree<T>::insert(const value_type &val)
+{
+    const std::string &key = val.first;
+    std::string data;
+    radix_serialize(data, val.second);
+    if (4 + key.size() + data.size() > MAX_ENTRY)
+        return false;
+
+    uint32_t id = m_root;
+    size_type pos = 0;
+    trie_page trie;
+    entries_type entries;
+    while (load(id, trie, entries) == TRIE_PAGE)
+    {
+        size_type count = common_prefix(trie.m_prefix, key, pos);
+        bool split = count < trie.m_prefix.size();
+        if (split)
+        {
+            //key在边上分叉或结束，边的剩余部分连同原有内容移到新的下层trie页
+            trie_page lower = trie;
+            lower.m_prefix = trie.m_prefix.substr(count + 1);
+            uint32_t low = allocate();
+            store_trie(low, lower);
+
+            trie_page upper;
+            upper.m_prefix = trie.m_prefix.substr(0, count);
+            upper.m_child[static_cast<unsigned char>(trie.m_prefix[count])] = low;
+            trie = upper;
+        }
+        pos += trie.m_prefix.size();
+
+        if (pos == key.size())
+        {
+            if (trie.m_has_value)
+                return false;
+            trie.m_has_value = true;
+            trie.m_value = data;
+            store_trie(id, trie);
+            m_size++;
+            return true;
+        }
+
+        unsigned char c = static_cast<unsigned char>(key[pos++]);
+        if (trie.m_child[c] == 0)
+        {
+            entries_type single(1, std::make_pair(key.substr(pos), data));
+            trie.m_child[c] = allocate();
+            store_container(trie.m_child[c], single);
+            store_trie(id, trie);
+            m_size++;
+            return true;
+        }
+        if (split)
+            store_trie(id, trie);
+        id = trie.m_child[c];
+    }
+
+    std::pair<std::string, std::string> entry(key.substr(pos), data);
+    typename entries_type::iterator it = std::lower_bound(entries.begin(), entries.end(), entry, entry_less);
+    if (it != entries.end() && it->first == entry.first)
+        return false;
+    entries.insert(it, entry);
+    store_entries(id, entries);
+    m_size++;
+    return true;
+}
+
+template <typename T>
+bool radix_paged_tree<T>::erase(const std::string &key)
+{
+    std::vector<std::pair<uint32_t, unsigned char> > path;
+    uint32_t id = m_root;
+    size_type pos = 0;
+    trie_page trie;
+    entries_type entries;
+    while (load(id, trie, entries) == TRIE_PAGE)
+    {
+        if (key.compare(pos, trie.m_prefix.size(), trie.m_prefix) != 0)
+            return false;
+        pos += trie.m_prefix.size();
+        if (pos == key.size())
+        {
+            if (!trie.m_has_value)
+                return false;
+            trie.m_has_value = false;
+            trie.m_value.clear();
+            m_size--;
+            if (id != m_root && trie.empty())
+            {
+                release(id);
+                unlink(path);
+            }
+            else
+                store_trie(id, trie);
+            return true;
+        }
+        unsigned char c = static_cast<unsigned char>(key[pos++]);
+        if (trie.m_child[c] == 0)
+            return false;
+        path.push_back(std::make_pair(id, c));
+        id = trie.m_child[c];
+    }
+
+    std::pair<std::string, std::string> target(key.substr(pos), std::string());
+    typename entries_type::iterator it = std::lower_bound(entries.begin(), entries.end(), target, entry_less);
+    if (it == entries.end() || it->first != target.first)
+        return false;
+    entries.erase(it);
+    m_size--;
+    if (entries.empty() && id != m_root)
+    {
+        release(id);
+        unlink(path);
+    }
+    else
+        store_container(id, entries);
+    return true;
+}
+
+template <typename T>
+int radix_paged_tree<T>::load(uint32_t id, trie_page &trie, entries_type &entries)
+{
+    const char *p = m_pool.pin(id);
+    int type = p[0];
+    if (type == TRIE_PAGE)
+    {
+        trie.m_has_value = p[1] != 0;
+        size_type len_prefix = get16(p + 2);
+        size_type len_value = get16(p + 4);
+        memcpy(trie.m_child, p + 8, sizeof(trie.m_child));
+        trie.m_prefix.assign(p + TRIE_HEADER, len_prefix);
+        trie.m_value.assign(p + TRIE_HEADER + len_prefix, len_value);
+    }
+    else
+    {
+        entries.clear();
+        size_type count = get16(p + 2);
+        entries.reserve(count);
+        for (size_type i = 0; i < count; i++)
+        {
+            const char *q = container_entry(p, i);
+            size_type len_suffix = get16(q);
+            size_type len_value = get16(q + 2);
+            entries.push_back(std::make_pair(std::string(q + 4, len_suffix), std::string(q + 4 + len_suffix, len_value)));
+        }
+    }
+    m_pool.unpin(id, false);
+    return type;
+}
+
+template <typename T>
+void radix_paged_tree<T>::store_trie(uint32_t id, const trie_page &trie)
+{
+    assert(TRIE_HEADER + trie.m_prefix.size() + trie.m_value.size() <= radix_page_pool::PAGE_SIZE);
+    char *p = m_pool.pin(id);
+    memset(p, 0, radix_page_pool::PAGE_SIZE);
+    p[0] = TRIE_PAGE;
+    p[1] = trie.m_has_value;
+    put16(p + 2, trie.m_prefix.size());
+    put16(p + 4, trie.m_value.size());
+    memcpy(p + 8, trie.m_child, sizeof(trie.m_child));
+    memcpy(p + TRIE_HEADER, trie.m_prefix.data(), trie.m_prefix.size());
+    memcpy(p + TRIE_HEADER + trie.m_prefix.size(), trie.m_value.data(), trie.m_value.size());
+    m_pool.unpin(id, true);
+}
+
+template <typename T>
+void radix_paged_tree<T>::store_container(uint32_t id, const entries_type &entries)
+{
+    assert(container_size(entries) <= radix_page_pool::PAGE_SIZE);
+    char *p = m_pool.pin(id);
+    memset(p, 0, radix_page_pool::PAGE_SIZE);
+    p[0] = CONTAINER_PAGE;
+    put16(p + 2, entries.size());
+    char *q = p + CONTAINER_HEADER + 2 * entries.size();
+    typename entries_type::const_iterator it;
+    for (it = entries.begin(); it != entries.end(); ++it)
+    {
+        put16(p + CONTAINER_HEADER + 2 * (it - entries.begin()), q - p);
+        put16(q, it->first.size());
+        put16(q + 2, it->second.size());
+        memcpy(q + 4, it->first.data(), it->first.size());
+        memcpy(q + 4 + it->first.size(), it->second.data(), it->second.size());
+        q += 4 + it->first.size() + it->second.size();
+    }
+    m_pool.unpin(id, true);
+}
+
+template <typename T>
+void radix_paged_tree<T>::store_entries(uint32_t id, const entries_type &entries)
+{
+    if (container_size(entries) <= radix_page_pool::PAGE_SIZE)
+    {
+        store_container(id, entries);
+        return;
+    }
+
+    //分裂：所有后缀的公共前缀作为trie页的边
+    std::string lcp = entries.front().first;
+    typename entries_type::const_iterator it;
+    for (it = entries.begin() + 1; it != entries.end(); ++it)
+        lcp.resize(common_prefix(lcp, it->first, 0));
+    if (lcp.size() > MAX_PREFIX)
+        lcp.resize(MAX_PREFIX);
+
+    trie_page trie;
+    trie.m_prefix = lcp;
+    it = entries.begin();
+    if (it->first.size() == lcp.size())
+    {
+        trie.m_has_value = true;
+        trie.m_value = it->second;
+        ++it;
+    }
+
+    //按公共前缀之后的字节分组，每组写入新的页；新页追加在文件末尾，
+    //按字节顺序且先于下一组分配，与collect的访问顺序一致
+    while (it != entries.end())
+    {
+        unsigned char c = static_cast<unsigned char>(it->first[lcp.size()]);
+        entries_type group;
+        for (; it != entries.end() && static_cast<unsigned char>(it->first[lcp.size()]) == c; ++it)
+            group.push_back(std::make_pair(it->first.substr(lcp.size() + 1), it->second));
+        trie.m_child[c] = m_pool.extend();
+        store_entries(trie.m_child[c], group);
+    }
+    store_trie(id, trie);
+}
+
+template <typename T>
+void radix_paged_tree<T>::store_header()
+{
+    char *p = m_pool.pin(0);
+    uint32_t magic = MAGIC;
+    uint64_t size = m_size;
+    memcpy(p, &magic, sizeof(magic));
+    memcpy(p + 4, &m_root, sizeof(m_root));
+    memcpy(p + 8, &m_free, sizeof(m_free));
+    memcpy(p + 12, &size, sizeof(size));
+    m_pool.unpin(0, true);
+}
+
+template <typename T>
+uint32_t radix_paged_tree<T>::allocate()
+{
+    if (m_free == 0)
+        return m_pool.extend();
+
+    //空闲页链表，下一个空闲页号保存在页的第4个字节
+    uint32_t id = m_free;
+    const char *p = m_pool.pin(id);
+    memcpy(&m_free, p + 4, sizeof(m_free));
+    m_pool.unpin(id, false);
+    return id;
+}
+
+template <typename T>
+void radix_paged_tree<T>::release(uint32_t id)
+{
+    char *p = m_pool.pin(id);
+    memset(p, 0, radix_page_pool::PAGE_SIZE);
+    p[0] = FREE_PAGE;
+    memcpy(p + 4, &m_free, sizeof(m_free));
+    m_pool.unpin(id, true);
+    m_free = id;
+}
+
+template <typename T>
+void radix_paged_tree<T>::unlink(std::vector<std::pair<uint32_t, unsigned char> > &path)
+{
+    trie_page trie;
+    entries_type entries;
+    while (!path.empty())
+    {
+        uint32_t id = path.back().first;
+        load(id, trie, entries);
+        trie.m_child[path.back().second] = 0;
+        path.pop_back();
+        if (id == m_root || !trie.empty())
+        {
+            store_trie(id, trie);
+            return;
+        }
+        release(id);
+    }
+}
+
+template <typename T>
+void radix_paged_tree<T>::collect(uint32_t id, const std::string &path, std::vector<std::pair<std::string, T> > &vec)
+{
+    trie_page trie;
+    entries_type entries;
+    if (load(id, trie, entries) == CONTAINER_PAGE)
+    {
+        typename entries_type::iterator it;
+        for (it = entries.begin(); it != entries.end(); ++it)
+            vec.push_back(std::pair<std::string, T>(path + it->first, decode(it->second)));
+        return;
+    }
+
+    std::string prefix = path + trie.m_prefix;
+    if (trie.m_has_value)
+        vec.push_back(std::pair<std::string, T>(prefix, decode(trie.m_value)));
+    for (int c = 0; c < 256; c++)
+        if (trie.m_child[c] != 0)
+            collect(trie.m_child[c], prefix + static_cast<char>(c), vec);
+}
+
+template <typename T>
+typename radix_paged_tree<T>::size_type radix_paged_tree<T>::container_size(const entries_type &entries)
+{
+    size_type size = CONTAINER_HEADER;
+    typename entries_type::const_iterator it;
+    for (it = entries.begin(); it != entries.end(); ++it)
+        size += 2 + 4 + it->first.size() + it->second.size();
+    return size;
+}
+
+template <typename T>
+typename radix_paged_tree<T>::size_type radix_paged_tree<T>::search_container(const char *p, const char *s, size_type len, bool upper)
+{
+    size_type lo = 0;
+    size_type hi = get16(p + 2);
+    while (lo < hi)
+    {
+        size_type mid = (lo + hi) / 2;
+        int cmp = compare_entry(container_entry(p, mid), s, len);
+        if (cmp < 0 || (upper && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+#endif //RADIX_PAGED_TREE
@@ -0,0 +1,814 @@
+#ifndef RADIX_PERSISTENT_TREE
+#define RADIX_PERSISTENT_TREE
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "radix_tree.h"
+
+template <typename K, typename T> class radix_persistent_tree;
+template <typename K, typename T> class radix_persistent_it;
+
+/**
+ * @brief 持久化基数树的节点
+ * @note 节点可能被多个版本共享，只有m_edit等于树当前编辑号的节点才允许原地修改，
+ * 其余节点修改前先复制（路径复制）。节点不保存父节点指针，否则无法共享。
+ */
+template <typename K, typename T>
+class radix_persistent_node
+{
+    friend class radix_persistent_tree<K, T>;
+    friend class radix_persistent_it<K, T>;
+
+    typedef std::pair<const K, T> value_type;
+    typedef std::shared_ptr<radix_persistent_node<K, T> > node_ptr;
+    typedef typename std::map<K, node_ptr>::iterator iterator_child;
+    typedef typename std::map<K, node_ptr>::const_iterator const_iterator_child;
+
+public:
+    radix_persistent_node(unsigned long edit) : m_key(), m_value(NULL), m_children(), m_edit(edit), m_is_leaf(false) {}
+    radix_persistent_node(const value_type &val, unsigned long edit) : m_key(), m_value(NULL), m_children(), m_edit(edit), m_is_leaf(true)
+    {
+        m_value = new value_type(val);
+    }
+
+    /**
+     * @note 子节点只复制指针，与原节点共享
+     */
+    radix_persistent_node(const radix_persistent_node &r, unsigned long edit)
+        : m_key(r.m_key), m_value(NULL), m_children(r.m_children), m_edit(edit), m_is_leaf(r.m_is_leaf)
+    {
+        if (r.m_value != NULL)
+            m_value = new value_type(*r.m_value);
+    }
+
+    ~radix_persistent_node()
+    {
+        delete m_value;
+    }
+
+private:
+    //成员变量
+    K m_key;
+    value_type *m_value;
+    std::map<K, node_ptr> m_children;
+
+    /**
+     * @note 创建该节点的树的编辑号
+     */
+    unsigned long m_edit;
+    bool m_is_leaf;
+
+    radix_persistent_node(const radix_persistent_node &);
+    radix_persistent_node &operator=(const radix_persistent_node &);
+};
+
+/**
+ * @brief 持久化基数树的只读迭代器
+ * @note 迭代器持有版本的根节点，版本被释放后迭代器仍然有效；
+ * 但对同一棵树未快照的修改会使其迭代器失效，与radix_tree相同
+ */
+template <typename K, typename T>
+class radix_persistent_it : public std::iterator<std::forward_iterator_tag, const std::pair<const K, T> >
+{
+    friend class radix_persistent_tree<K, T>;
+
+    typedef radix_persistent_node<K, T> node_type;
+    typedef typename node_type::const_iterator_child const_iterator_child;
+
+public:
+    radix_persistent_it() : m_root(), m_stack(), m_leaf(NULL) {}
+
+    const std::pair<const K, T> &operator*() const
+    {
+        return *m_leaf->m_value;
+    }
+
+    const std::pair<const K, T> *operator->() const
+    {
+        return m_leaf->m_value;
+    }
+
+    radix_persistent_it<K, T> &operator++()
+    {
+        if (m_leaf != NULL)
+            next();
+        return *this;
+    }
+
+    radix_persistent_it<K, T> operator++(int)
+    {
+        radix_persistent_it<K, T> copy(*this);
+        ++(*this);
+        return copy;
+    }
+
+    bool operator!=(const radix_persistent_it<K, T> &r) const
+    {
+        return m_leaf != r.m_leaf;
+    }
+
+    bool operator==(const radix_persistent_it<K, T> &r) const
+    {
+        return m_leaf == r.m_leaf;
+    }
+
+private:
+    //成员变量
+    std::shared_ptr<const node_type> m_root;
+
+    /**
+     * @note 从根节点到叶子节点的路径，每一项为路径上的节点及其通往下一层的子节点
+     */
+    std::vector<std::pair<const node_type *, const_iterator_child> > m_stack;
+    const node_type *m_leaf;
+
+    //基本函数
+    /**
+     * @brief 从node开始沿最左子节点向下到达叶子节点
+     */
+    void first_leaf(const node_type *node)
+    {
+        while (!node->m_is_leaf)
+        {
+            const_iterator_child it = node->m_children.begin();
+            m_stack.push_back(std::make_pair(node, it));
+            node = it->second.get();
+        }
+        m_leaf = node;
+    }
+
+    /**
+     * @brief 沿路径回溯寻找下一个兄弟节点，并进入其最左叶子节点
+     */
+    void next()
+    {
+        while (!m_stack.empty())
+        {
+            std::pair<const node_type *, const_iterator_child> &top = m_stack.back();
+            ++top.second;
+            if (top.second != top.first->m_children.end())
+            {
+                first_leaf(top.second->second.get());
+                return;
+            }
+            m_stack.pop_back();
+        }
+        m_leaf = NULL;
+        m_root.reset();
+    }
+};
+
+/**
+ * @brief 持久化（结构共享）基数树
+ * 复制和snapshot()的复杂度为O(1)，两棵树共享全部节点；之后任意一方的insert/erase只复制
+ * 从根到修改位置的路径，未修改的子树继续共享。同一版本上连续的修改原地进行，直到下一次
+ * 快照，因此一批修改只复制一次路径。旧版本在所有副本和迭代器释放后回收。
+ * @note 已冻结的节点不再修改，不同线程可以同时读取不同的副本；同一副本的读写仍需外部同步
+ */
+template <typename K, typename T>
+class radix_persistent_tree
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef radix_persistent_it<K, T> iterator;
+    typedef radix_persistent_it<K, T> const_iterator;
+    typedef std::size_t size_type;
+
+    //构造函数
+    radix_persistent_tree() : m_size(0), m_root(), m_edit(next_edit()) {}
+
+    /**
+     * @brief 共享r的所有节点，并冻结r当前版本
+     */
+    radix_persistent_tree(const radix_persistent_tree &r) : m_size(r.m_size), m_root(r.m_root), m_edit(next_edit())
+    {
+        r.m_edit.store(next_edit());
+    }
+
+    radix_persistent_tree &operator=(const radix_persistent_tree &r)
+    {
+        if (this != &r)
+        {
+            m_size = r.m_size;
+            m_root = r.m_root;
+            m_edit.store(next_edit());
+            r.m_edit.store(next_edit());
+        }
+        return *this;
+    }
+
+    //成员函数
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void clear()
+    {
+        m_root.reset();
+        m_size = 0;
+    }
+
+    /**
+     * @brief 获取当前版本的只读快照，O(1)
+     * @note 对本树的后续修改不影响快照，回滚时将快照赋值回本树即可
+     */
+    radix_persistent_tree snapshot() const
+    {
+        return radix_persistent_tree(*this);
+    }
+
+    /**
+     * @brief 判断两棵树是否为同一版本（共享同一个根节点）
+     */
+    bool same_version(const radix_persistent_tree &r) const
+    {
+        return m_root == r.m_root;
+    }
+
+    iterator begin() const;
+
+    iterator end() const;
+
+    iterator find(const K &key) const;
+
+    /**
+     * @brief 寻找树中能够最长前缀匹配key的元素，若没有返回空迭代器
+     */
+    iterator longest_match(const K &key) const;
+
+    /**
+     * @brief 在树中寻找以key为前缀的所有元素
+     * @par key 为空匹配树中所有元素
+     */
+    void prefix_match(const K &key, std::vector<iterator> &vec) const;
+
+    /**
+     * @brief 插入元素，已存在时不修改并返回false
+     */
+    bool insert(const value_type &val);
+
+    /**
+     * @brief 获取key对应的值，不存在时插入默认值
+     * @note 返回的引用指向本树独占的叶子节点，在下一次快照或修改前有效
+     */
+    T &operator[](const K &key);
+
+    /**
+     * @brief 删除序列，如果树中不存在此序列返回false
+     */
+    bool erase(const K &key);
+
+    /**
+     * @brief 比较本树（旧）与other（新）的差异，两版本共享的子树直接跳过
+     * @note 对同一棵树的两个版本，复杂度与修改的元素个数成正比，而非元素总数
+     * @par changed 两树中值不同的元素，first指向本树，second指向other，要求T重载==
+     */
+    void diff(const radix_persistent_tree &other, std::vector<iterator> &added, std::vector<iterator> &removed,
+              std::vector<std::pair<iterator, iterator> > &changed) const;
+
+private:
+    typedef radix_persistent_node<K, T> node_type;
+    typedef typename node_type::node_ptr node_ptr;
+    typedef typename node_type::iterator_child iterator_child;
+    typedef typename node_type::const_iterator_child const_iterator_child;
+
+    size_type m_size;
+    node_ptr m_root;
+
+    /**
+     * @note 本树的编辑号，快照时更换，使已有节点全部冻结。
+     * 复制const对象时也会更换，为原子类型以便多个读线程同时复制同一版本
+     */
+    mutable std::atomic<unsigned long> m_edit;
+
+    static unsigned long next_edit()
+    {
+        static std::atomic<unsigned long> s_edit(0);
+        return ++s_edit;
+    }
+
+    /**
+     * @brief 保证slot指向本树可修改的节点，必要时复制节点
+     */
+    node_type *own(node_ptr &slot) const;
+
+    /**
+     * @brief 在node中查找首元素等于key[pos]的内部子节点
+     */
+    static const_iterator_child find_child(const node_type *node, const K &key, int pos);
+
+    static int common_prefix(const K &key1, int pos1, const K &key2, int pos2);
+
+    /**
+     * @brief 从根节点沿key向下查找，将经过的节点记录在it的路径中
+     * @par matched 返回最后一个节点末尾在key中的下标
+     * @par count 返回下一个子节点与key的公共前缀长度，没有子节点时为0
+     * @return 路径上最后一个节点
+     */
+    const node_type *descend(const K &key, iterator &it, int &matched, const_iterator_child &next, int &count) const;
+
+    /**
+     * @brief 在slot的子树中插入val，slot的key已经完全匹配
+     * @par depth slot的key在val中的起始下标
+     */
+    node_type *insert_at(node_ptr &slot, int depth, const value_type &val);
+
+    /**
+     * @brief 在slot的子树中删除key，调用前已确认key存在
+     */
+    void erase_at(node_ptr &slot, int depth, const K &key);
+
+    /**
+     * @brief 将node为根的子树中所有叶子节点添加到vec中
+     * @par it 已经定位到node的路径
+     */
+    static void get_leafs(const node_type *node, iterator &it, std::vector<iterator> &vec);
+
+    /**
+     * @brief 同步遍历两个版本，(a, oa)与(b, ob)对应相同的序列，指针相同的子树直接跳过
+     */
+    static void lockstep(const node_type *a, int oa, iterator &it_a, const node_type *b, int ob, iterator &it_b,
+                         std::vector<iterator> &added, std::vector<iterator> &removed,
+                         std::vector<std::pair<iterator, iterator> > &changed);
+};
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::iterator radix_persistent_tree<K, T>::begin() const
+{
+    iterator it;
+    if (m_size == 0)
+        return it;
+    it.m_root = m_root;
+    it.first_leaf(m_root.get());
+    return it;
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::iterator radix_persistent_tree<K, T>::end() const
+{
+    return iterator();
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::iterator radix_persistent_tree<K, T>::find(const K &key) const
+{
+    iterator it;
+    if (m_root == NULL)
+        return it;
+
+    int matched, count;
+    const_iterator_child next;
+    const node_type *node = descend(key, it, matched, next, count);
+    if (matched != radix_length(key))
+        return end();
+
+    const_iterator_child leaf = node->m_children.find(radix_substr(key, 0, 0));
+    if (leaf == node->m_children.end())
+        return end();
+    it.m_stack.push_back(std::make_pair(node, leaf));
+    it.m_leaf = leaf->second.get();
+    return it;
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::iterator radix_persistent_tree<K, T>::longest_match(const K &key) const
+{
+    iterator it;
+    if (m_root == NULL)
+        return it;
+
+    int matched, count;
+    const_iterator_child next;
+    descend(key, it, matched, next, count);
+
+    //沿路径自深向浅寻找叶子节点，路径上每个节点都是key的前缀
+    K nul = radix_substr(key, 0, 0);
+    const node_type *node = it.m_stack.empty() ? m_root.get() : it.m_stack.back().second->second.get();
+    while (true)
+    {
+        const_iterator_child leaf = node->m_children.find(nul);
+        if (leaf != node->m_children.end())
+        {
+            it.m_stack.push_back(std::make_pair(node, leaf));
+            it.m_leaf = leaf->second.get();
+            return it;
+        }
+        if (it.m_stack.empty())
+            return end();
+        node = it.m_stack.back().first;
+        it.m_stack.pop_back();
+    }
+}
+
+template <typename K, typename T>
+void radix_persistent_tree<K, T>::prefix_match(const K &key, std::vector<iterator> &vec) const
+{
+    vec.clear();
+    if (m_size == 0)
+        return;
+
+    iterator it;
+    int matched, count;
+    const_iterator_child next;
+    const node_type *node = descend(key, it, matched, next, count);
+    int len = radix_length(key);
+    if (matched < len)
+    {
+        //key在下一个子节点的边上结束，该子节点的整棵子树都以key为前缀
+        if (count == 0 || matched + count != len)
+            return;
+        it.m_stack.push_back(std::make_pair(node, next));
+        node = next->second.get();
+    }
+    get_leafs(node, it, vec);
+}
+
+template <typename K, typename T>
+bool radix_persistent_tree<K, T>::insert(const value_type &val)
+{
+    if (find(val.first) != end())
+        return false;
+
+    if (m_root == NULL)
+    {
+        m_root = std::make_shared<node_type>(m_edit);
+        m_root->m_key = radix_substr(val.first, 0, 0);
+    }
+    insert_at(m_root, 0, val);
+    m_size++;
+    return true;
+}
+
+template <typename K, typename T>
+T &radix_persistent_tree<K, T>::operator[](const K &key)
+{
+    if (find(key) == end())
+    {
+        std::pair<K, T> val;
+        val.first = key;
+        insert(val);
+    }
+
+    //沿路径复制节点，使叶子节点为本树独占
+    int len = radix_length(key);
+    int matched = 0;
+    node_ptr *slot = &m_root;
+    node_type *node = own(*slot);
+    while (matched < len)
+    {
+        iterator_child it = node->m_children.find(find_child(node, key, matched)->first);
+        matched += radix_length(it->first);
+        slot = &it->second;
+        node = own(*slot);
+    }
+    slot = &node->m_children.find(radix_substr(key, 0, 0))->second;
+    return own(*slot)->m_value->second;
+}
+
+template <typename K, typename T>
+bool radix_persistent_tree<K, T>::erase(const K &key)
+{
+    if (find(key) == end())
+        return false;
+
+    own(m_root);
+    erase_at(m_root, 0, key);
+    m_size--;
+    return true;
+}
+
+template <typename K, typename T>
+void radix_persistent_tree<K, T>::diff(const radix_persistent_tree &other, std::vector<iterator> &added,
+                                       std::vector<iterator> &removed, std::vector<std::pair<iterator, iterator> > &changed) const
+{
+    added.clear();
+    removed.clear();
+    changed.clear();
+    if (m_root == other.m_root)
+        return;
+
+    iterator it_a, it_b;
+    it_a.m_root = m_root;
+    it_b.m_root = other.m_root;
+    if (m_root == NULL || other.m_root == NULL)
+    {
+        if (m_root != NULL)
+            get_leafs(m_root.get(), it_a, removed);
+        if (other.m_root != NULL)
+            get_leafs(other.m_root.get(), it_b, added);
+        return;
+    }
+    lockstep(m_root.get(), 0, it_a, other.m_root.get(), 0, it_b, added, removed, changed);
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::node_type *radix_persistent_tree<K, T>::own(node_ptr &slot) const
+{
+    if (slot->m_edit != m_edit)
+        slot = std::make_shared<node_type>(*slot, m_edit);
+    return slot.get();
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::const_iterator_child radix_persistent_tree<K, T>::find_child(const node_type *node, const K &key, int pos)
+{
+    const_iterator_child it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        if (!it->second->m_is_leaf && it->first[0] == key[pos])
+            return it;
+    return node->m_children.end();
+}
+
+template <typename K, typename T>
+int radix_persistent_tree<K, T>::common_prefix(const K &key1, int pos1, const K &key2, int pos2)
+{
+    int len1 = radix_length(key1) - pos1;
+    int len2 = radix_length(key2) - pos2;
+    int count = 0;
+    while (count < len1 && count < len2 && key1[pos1 + count] == key2[pos2 + count])
+        count++;
+    return count;
+}
+
+template <typename K, typename T>
+const typename radix_persistent_tree<K, T>::node_type *radix_persistent_tree<K, T>::descend(
+    const K &key, iterator &it, int &matched, const_iterator_child &next, int &count) const
+{
+    it.m_root = m_root;
+    int len = radix_length(key);
+    const node_type *node = m_root.get();
+    matched = 0;
+    count = 0;
+    while (matched < len)
+    {
+        next = find_child(node, key, matched);
+        if (next == node->m_children.end())
+            break;
+        int len_child = radix_length(next->first);
+        count = common_prefix(next->first, 0, key, matched);
+        if (count < len_child)
+            break;
+        it.m_stack.push_back(std::make_pair(node, next));
+        node = next->second.get();
+        matched += len_child;
+        count = 0;
+    }
+    return node;
+}
+
+template <typename K, typename T>
+typename radix_persistent_tree<K, T>::node_type *radix_persistent_tree<K, T>::insert_at(node_ptr &slot, int depth, const value_type &val)
+{
+    node_type *node = own(slot);
+    int len = radix_length(val.first);
+    int matched = depth + radix_length(node->m_key);
+
+    if (matched == len)
+    {
+        node_ptr leaf = std::make_shared<node_type>(val, m_edit);
+        leaf->m_key = radix_substr(val.first, 0, 0);
+        node->m_children[leaf->m_key] = leaf;
+        return leaf.get();
+    }
+
+    const_iterator_child child = find_child(node, val.first, matched);
+    if (child == node->m_children.end())
+    {
+        node_ptr p = std::make_shared<node_type>(m_edit);
+        p->m_key = radix_substr(val.first, matched, len - matched);
+        node->m_children[p->m_key] = p;
+        return insert_at(node->m_children[p->m_key], matched, val);
+    }
+
+    int len_child = radix_length(child->first);
+    int count = common_prefix(child->first, 0, val.first, matched);
+    if (count == len_child)
+        return insert_at(node->m_children[child->first], matched, val);
+
+    //val在child的边上分叉或结束，拆分child，拆分后的下半部分需要修改key，因此复制
+    K child_key = child->first;
+    node_ptr lower = child->second;
+    node->m_children.erase(child_key);
+    own(lower)->m_key = radix_substr(lower->m_key, count, len_child - count);
+
+    node_ptr p = std::make_shared<node_type>(m_edit);
+    p->m_key = radix_substr(val.first, matched, count);
+    p->m_children[lower->m_key] = lower;
+    node->m_children[p->m_key] = p;
+    return insert_at(node->m_children[p->m_key], matched, val);
+}
+
+template <typename K, typename T>
+void radix_persistent_tree<K, T>::erase_at(node_ptr &slot, int depth, const K &key)
+{
+    node_type *node = slot.get();
+    int matched = depth + radix_length(node->m_key);
+    if (matched == radix_length(key))
+    {
+        node->m_children.erase(radix_substr(key, 0, 0));
+        return;
+    }
+
+    K child_key = find_child(node, key, matched)->first;
+    node_ptr &child_slot = node->m_children[child_key];
+    node_type *child = own(child_slot);
+    erase_at(child_slot, matched, key);
+
+    //删除后子节点为空则移除，只剩一个内部子节点则与其合并
+    if (child->m_children.empty())
+    {
+        node->m_children.erase(child_key);
+    }
+    else if (child->m_children.size() == 1 && !child->m_children.begin()->second->m_is_leaf)
+    {
+        node_ptr grandchild = child->m_children.begin()->second;
+        node->m_children.erase(child_key);
+        own(grandchild)->m_key = radix_join(child_key, grandchild->m_key);
+        node->m_children[grandchild->m_key] = grandchild;
+    }
+}
+
+template <typename K, typename T>
+void radix_persistent_tree<K, T>::get_leafs(const node_type *node, iterator &it, std::vector<iterator> &vec)
+{
+    if (node->m_is_leaf)
+    {
+        it.m_leaf = node;
+        vec.push_back(it);
+        return;
+    }
+
+    const_iterator_child child;
+    for (child = node->m_children.begin(); child != node->m_children.end(); ++child)
+    {
+        it.m_stack.push_back(std::make_pair(node, child));
+        get_leafs(child->second.get(), it, vec);
+        it.m_stack.pop_back();
+    }
+}
+
+template <typename K, typename T>
+void radix_persistent_tree<K, T>::lockstep(const node_type *a, int oa, iterator &it_a, const node_type *b, int ob, iterator &it_b,
+                                           std::vector<iterator> &added, std::vector<iterator> &removed,
+                                           std::vector<std::pair<iterator, iterator> > &changed)
+{
+    //两个版本共享的子树没有差异
+    if (a == b && oa == ob)
+        return;
+
+    int len_a = radix_length(a->m_key);
+    int len_b = radix_length(b->m_key);
+    while (oa < len_a && ob < len_b && a->m_key[oa] == b->m_key[ob])
+    {
+        oa++;
+        ob++;
+    }
+
+    const_iterator_child child_a, child_b;
+
+    if (oa < len_a && ob < len_b)
+    {
+        get_leafs(a, it_a, removed);
+        get_leafs(b, it_b, added);
+        return;
+    }
+
+    //b节点先结束，在b的子节点中继续匹配a的剩余部分
+    if (oa < len_a)
+    {
+        bool matched = false;
+        for (child_b = b->m_children.begin(); child_b != b->m_children.end(); ++child_b)
+        {
+            it_b.m_stack.push_back(std::make_pair(b, child_b));
+            if (!child_b->second->m_is_leaf && child_b->first[0] == a->m_key[oa])
+            {
+                lockstep(a, oa, it_a, child_b->second.get(), 0, it_b, added, removed, changed);
+                matched = true;
+            }
+            else
+                get_leafs(child_b->second.get(), it_b, added);
+            it_b.m_stack.pop_back();
+        }
+        if (!matched)
+            get_leafs(a, it_a, removed);
+        return;
+    }
+
+    //a节点先结束，在a的子节点中继续匹配b的剩余部分
+    if (ob < len_b)
+    {
+        bool matched = false;
+        for (child_a = a->m_children.begin(); child_a != a->m_children.end(); ++child_a)
+        {
+            it_a.m_stack.push_back(std::make_pair(a, child_a));
+            if (!child_a->second->m_is_leaf && child_a->first[0] == b->m_key[ob])
+            {
+                lockstep(child_a->second.get(), 0, it_a, b, ob, it_b, added, removed, changed);
+                matched = true;
+            }
+            else
+                get_leafs(child_a->second.get(), it_a, removed);
+            it_a.m_stack.pop_back();
+        }
+        if (!matched)
+            get_leafs(b, it_b, added);
+        return;
+    }
+
+    //两节点同时结束，按有序map归并子节点
+    child_a = a->m_children.begin();
+    child_b = b->m_children.begin();
+    while (child_a != a->m_children.end() || child_b != b->m_children.end())
+    {
+        bool end_a = child_a == a->m_children.end();
+        bool end_b = child_b == b->m_children.end();
+        bool nul_a = !end_a && radix_length(child_a->first) == 0;
+        bool nul_b = !end_b && radix_length(child_b->first) == 0;
+        bool take_a, take_b;
+        if (!end_a && !end_b && ((nul_a && nul_b) || (!nul_a && !nul_b && child_a->first[0] == child_b->first[0])))
+            take_a = take_b = true;
+        else if (end_b || (!end_a && (nul_a || (!nul_b && child_a->first < child_b->first))))
+            take_a = true, take_b = false;
+        else
+            take_a = false, take_b = true;
+
+        if (take_a)
+            it_a.m_stack.push_back(std::make_pair(a, child_a));
+        if (take_b)
+            it_b.m_stack.push_back(std::make_pair(b, child_b));
+
+        if (take_a && take_b)
+        {
+            const node_type *node_a = child_a->second.get();
+            const node_type *node_b = child_b->second.get();
+            if (!nul_a)
+                lockstep(node_a, 0, it_a, node_b, 0, it_b, added, removed, changed);
+            else if (node_a != node_b && !(node_a->m_value->second == node_b->m_value->second))
+            {
+                it_a.m_leaf = node_a;
+                it_b.m_leaf = node_b;
+                changed.push_back(std::make_pair(it_a, it_b));
+            }
+        }
+        else if (take_a)
+            get_leafs(child_a->second.get(), it_a, removed);
+        else
+            get_leafs(child_b->second.get(), it_b, added);
+
+        if (take_a)
+        {
+            it_a.m_stack.pop_back();
+            ++child_a;
+        }
+        if (take_b)
+        {
+            it_b.m_stack.pop_back();
+            ++child_b;
+        }
+    }
+}
+
+/**
+ * @brief 在读线程和写线程之间原子地发布持久化基数树的版本
+ * 写线程在自己的副本上完成一批修改后调用publish，读线程通过current()获取快照，
+ * 因此只会看到修改前或修改后的完整版本。保存旧的快照即可回滚。
+ */
+template <typename K, typename T>
+class radix_tree_publisher
+{
+public:
+    typedef radix_persistent_tree<K, T> tree_type;
+
+    radix_tree_publisher() : m_current(std::make_shared<const tree_type>()) {}
+
+    /**
+     * @brief 获取当前发布的版本，返回的版本在持有期间保持不变
+     */
+    std::shared_ptr<const tree_type> current() const
+    {
+        return std::atomic_load(&m_current);
+    }
+
+    /**
+     * @brief 发布新版本，返回被替换的旧版本，可用于回滚
+     */
+    tree_type publish(const tree_type &tree)
+    {
+        std::shared_ptr<const tree_type> next = std::make_shared<const tree_type>(tree);
+        return *std::atomic_exchange(&m_current, next);
+    }
+
+private:
+    std::shared_ptr<const tree_type> m_current;
+};
+#endif //RADIX_PERSISTENT_TREE
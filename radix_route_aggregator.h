@@ -0,0 +1,361 @@
+#ifndef RADIX_ROUTE_AGGREGATOR
+#define RADIX_ROUTE_AGGREGATOR
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include "radix_tree.h"
+
+/**
+ * 构造只含一个二进制位的序列
+ * @par bit 0或1
+ * @note 与radix_substr等函数相同，由二进制序列类型K特化
+ */
+template <typename K>
+K radix_bit(int bit);
+
+/**
+ * @brief 路由聚合（ORTC）：生成转发等价且前缀数最少的转发表
+ * 在原始路由（RIB）的二叉树上分三步计算：
+ *  -补全：只有一个子节点的节点，缺失的一侧继承最近的上层路由
+ *  -自底向上：叶子的候选集为其下一跳；内部节点取两个子节点候选集的交集，交集为空时取并集
+ *  -自顶向下：继承的下一跳在候选集中时不生成路由，否则从候选集中选取一个生成路由
+ * 没有路由的区域不能被任何前缀覆盖，因此包含它的候选集直接取为"无路由"，
+ * 使其所有祖先都不生成路由；存在默认路由时结果的前缀数最少。
+ * 增量修改时只重新计算修改点以下的子树，并沿祖先向上直到候选集不再变化，
+ * 然后只替换该祖先范围内的转发表前缀。
+ * @par K 二进制序列类型，需要特化radix_bit，operator[]返回第n位
+ * @par Equal 下一跳的相等比较
+ */
+template <typename K, typename T, typename Equal = std::equal_to<T> >
+class radix_route_aggregator
+{
+public:
+    typedef radix_tree<K, T> tree_type;
+    typedef std::size_t size_type;
+
+    //构造函数
+    explicit radix_route_aggregator(const Equal &equal = Equal());
+
+    /**
+     * @brief 载入routes中的所有路由并聚合
+     */
+    explicit radix_route_aggregator(tree_type &routes, const Equal &equal = Equal());
+
+    ~radix_route_aggregator()
+    {
+        destroy(m_root);
+    }
+
+    //成员函数
+    /**
+     * @brief 插入或替换原始路由，并增量维护转发表
+     */
+    void insert(const K &key, const T &hop);
+
+    /**
+     * @brief 删除原始路由，并增量维护转发表
+     */
+    bool erase(const K &key);
+
+    /**
+     * @brief 重新计算整个转发表
+     */
+    void aggregate();
+
+    /**
+     * @brief 聚合后的转发表，调用方不应修改
+     */
+    tree_type &fib()
+    {
+        return m_fib;
+    }
+
+    /**
+     * @brief 原始路由的个数
+     */
+    size_type size() const
+    {
+        return m_size;
+    }
+
+private:
+    /**
+     * @note 下一跳以m_hops中的下标表示，0表示无路由
+     *  m_set为有序的候选集，m_chosen为转发表在该节点处实际生效的下一跳
+     */
+    struct node
+    {
+        K m_key;
+        node *m_child[2];
+        node *m_parent;
+        int m_hop;
+        std::vector<int> m_set;
+        int m_chosen;
+
+        node(const K &key, node *parent) : m_key(key), m_parent(parent), m_hop(0), m_set(), m_chosen(0)
+        {
+            m_child[0] = m_child[1] = NULL;
+        }
+    };
+
+    Equal m_equal;
+    std::vector<T> m_hops;
+    node *m_root;
+    size_type m_size;
+    tree_type m_fib;
+
+    radix_route_aggregator(const radix_route_aggregator &);
+    radix_route_aggregator &operator=(const radix_route_aggregator &);
+
+    static void destroy(node *n);
+
+    int hop_id(const T &hop);
+
+    /**
+     * @brief n的上层路由中最近的下一跳，不包括n本身
+     */
+    static int inherited(node *n);
+
+    /**
+     * @brief 由子节点的候选集计算n的候选集
+     * @par in 上层路由的下一跳，不包括n本身
+     */
+    static void compute_set(node *n, int in, std::vector<int> &set);
+
+    /**
+     * @brief 自底向上重新计算n为根的子树中所有候选集
+     */
+    static void compute_subtree(node *n, int in);
+
+    /**
+     * @brief 自顶向下为n为根的子树选取下一跳，生成转发表前缀
+     * @par up 转发表在n的父节点处生效的下一跳
+     */
+    void select(node *n, int up, int in);
+
+    /**
+     * @brief 从start开始重新计算候选集，并替换受影响范围内的转发表前缀
+     */
+    void update(node *start);
+};
+
+template <typename K, typename T, typename Equal>
+radix_route_aggregator<K, T, Equal>::radix_route_aggregator(const Equal &equal)
+    : m_equal(equal), m_hops(1), m_root(new node(K(), NULL)), m_size(0), m_fib()
+{
+    m_root->m_set.push_back(0);
+}
+
+template <typename K, typename T, typename Equal>
+radix_route_aggregator<K, T, Equal>::radix_route_aggregator(tree_type &routes, const Equal &equal)
+    : m_equal(equal), m_hops(1), m_root(new node(K(), NULL)), m_size(0), m_fib()
+{
+    //先建立完整的二叉树，再一次性聚合
+    typename tree_type::iterator it;
+    for (it = routes.begin(); it != routes.end(); ++it)
+    {
+        node *n = m_root;
+        int len = radix_length(it->first);
+        for (int i = 0; i < len; i++)
+        {
+            int bit = it->first[i] ? 1 : 0;
+            if (n->m_child[bit] == NULL)
+                n->m_child[bit] = new node(radix_join(n->m_key, radix_bit<K>(bit)), n);
+            n = n->m_child[bit];
+        }
+        if (n->m_hop == 0)
+            m_size++;
+        n->m_hop = hop_id(it->second);
+    }
+    aggregate();
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::insert(const K &key, const T &hop)
+{
+    node *n = m_root;
+    node *start = NULL;
+    int len = radix_length(key);
+    for (int i = 0; i < len; i++)
+    {
+        int bit = key[i] ? 1 : 0;
+        if (n->m_child[bit] == NULL)
+        {
+            n->m_child[bit] = new node(radix_join(n->m_key, radix_bit<K>(bit)), n);
+            //新建路径的顶端原本是父节点缺失的一侧，转发表前缀需要从这里开始替换
+            if (start == NULL)
+                start = n->m_child[bit];
+        }
+        n = n->m_child[bit];
+    }
+    if (n->m_hop == 0)
+        m_size++;
+    n->m_hop = hop_id(hop);
+    update(start == NULL ? n : start);
+}
+
+template <typename K, typename T, typename Equal>
+bool radix_route_aggregator<K, T, Equal>::erase(const K &key)
+{
+    node *n = m_root;
+    int len = radix_length(key);
+    for (int i = 0; i < len && n != NULL; i++)
+        n = n->m_child[key[i] ? 1 : 0];
+    if (n == NULL || n->m_hop == 0)
+        return false;
+
+    n->m_hop = 0;
+    m_size--;
+
+    //删除不再有路由的叶子路径
+    while (n != m_root && n->m_hop == 0 && n->m_child[0] == NULL && n->m_child[1] == NULL)
+    {
+        node *parent = n->m_parent;
+        parent->m_child[parent->m_child[1] == n ? 1 : 0] = NULL;
+        delete n;
+        n = parent;
+    }
+    update(n);
+    return true;
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::aggregate()
+{
+    m_fib.clear();
+    compute_subtree(m_root, 0);
+    select(m_root, 0, 0);
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::destroy(node *n)
+{
+    if (n == NULL)
+        return;
+    destroy(n->m_child[0]);
+    destroy(n->m_child[1]);
+    delete n;
+}
+
+template <typename K, typename T, typename Equal>
+int radix_route_aggregator<K, T, Equal>::hop_id(const T &hop)
+{
+    //不同的下一跳通常很少，线性查找即可
+    for (size_type i = 1; i < m_hops.size(); i++)
+        if (m_equal(m_hops[i], hop))
+            return i;
+    m_hops.push_back(hop);
+    return m_hops.size() - 1;
+}
+
+template <typename K, typename T, typename Equal>
+int radix_route_aggregator<K, T, Equal>::inherited(node *n)
+{
+    for (n = n->m_parent; n != NULL; n = n->m_parent)
+        if (n->m_hop != 0)
+            return n->m_hop;
+    return 0;
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::compute_set(node *n, int in, std::vector<int> &set)
+{
+    if (n->m_hop != 0)
+        in = n->m_hop;
+
+    set.clear();
+    if (n->m_child[0] == NULL && n->m_child[1] == NULL)
+    {
+        set.push_back(in);
+        return;
+    }
+
+    //缺失的一侧继承上层路由
+    std::vector<int> single(1, in);
+    const std::vector<int> &a = n->m_child[0] ? n->m_child[0]->m_set : single;
+    const std::vector<int> &b = n->m_child[1] ? n->m_child[1]->m_set : single;
+
+    //无路由的区域不能被覆盖
+    if (a[0] == 0 || b[0] == 0)
+    {
+        set.push_back(0);
+        return;
+    }
+
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(set));
+    if (set.empty())
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(set));
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::compute_subtree(node *n, int in)
+{
+    int in_child = n->m_hop != 0 ? n->m_hop : in;
+    for (int bit = 0; bit < 2; bit++)
+        if (n->m_child[bit] != NULL)
+            compute_subtree(n->m_child[bit], in_child);
+    compute_set(n, in, n->m_set);
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::select(node *n, int up, int in)
+{
+    int chosen = up;
+    if (!std::binary_search(n->m_set.begin(), n->m_set.end(), up))
+    {
+        //优先保留原始路由的下一跳
+        chosen = std::binary_search(n->m_set.begin(), n->m_set.end(), n->m_hop) ? n->m_hop : n->m_set[0];
+        assert(chosen != 0);
+        m_fib[n->m_key] = m_hops[chosen];
+    }
+    n->m_chosen = chosen;
+
+    if (n->m_hop != 0)
+        in = n->m_hop;
+    if (n->m_child[0] == NULL && n->m_child[1] == NULL)
+        return;
+
+    for (int bit = 0; bit < 2; bit++)
+    {
+        if (n->m_child[bit] != NULL)
+            select(n->m_child[bit], chosen, in);
+        else if (in != chosen)
+        {
+            //缺失的一侧继承的下一跳与转发表不同，需要单独的前缀
+            assert(in != 0);
+            m_fib[radix_join(n->m_key, radix_bit<K>(bit))] = m_hops[in];
+        }
+    }
+}
+
+template <typename K, typename T, typename Equal>
+void radix_route_aggregator<K, T, Equal>::update(node *start)
+{
+    compute_subtree(start, inherited(start));
+
+    //沿祖先向上，直到候选集不再变化
+    node *top = start;
+    std::vector<int> set;
+    for (node *n = start->m_parent; n != NULL; n = n->m_parent)
+    {
+        compute_set(n, inherited(n), set);
+        if (set == n->m_set)
+            break;
+        n->m_set.swap(set);
+        top = n;
+    }
+
+    //top的父节点的候选集与选取都未变化，只需替换top范围内的转发表前缀
+    std::vector<typename tree_type::iterator> vec;
+    m_fib.prefix_match(top->m_key, vec);
+    std::vector<K> keys;
+    for (size_type i = 0; i < vec.size(); i++)
+        keys.push_back(vec[i]->first);
+    for (size_type i = 0; i < keys.size(); i++)
+        m_fib.erase(keys[i]);
+
+    select(top, top->m_parent ? top->m_parent->m_chosen : 0, inherited(top));
+}
+#endif //RADIX_ROUTE_AGGREGATOR
@@ -0,0 +1,52 @@
+#ifndef RADIX_SERIALIZE
+#define RADIX_SERIALIZE
+
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * 将val追加到out末尾
+ * 默认按内存布局复制，只适用于可平凡复制的类型，其他类型需要特化
+ */
+template <typename V>
+void radix_serialize(std::string &out, const V &val)
+{
+    static_assert(std::is_trivially_copyable<V>::value, "radix_serialize needs a specialization for this type");
+    out.append(reinterpret_cast<const char *>(&val), sizeof(V));
+}
+
+/**
+ * 从p开始读取val，成功时将p移动到val之后
+ * @return 剩余数据不足时返回false
+ */
+template <typename V>
+bool radix_deserialize(const char *&p, const char *end, V &val)
+{
+    static_assert(std::is_trivially_copyable<V>::value, "radix_deserialize needs a specialization for this type");
+    if (end - p < (long)sizeof(V))
+        return false;
+    memcpy(&val, p, sizeof(V));
+    p += sizeof(V);
+    return true;
+}
+
+template <>
+inline void radix_serialize<std::string>(std::string &out, const std::string &val)
+{
+    unsigned int len = val.size();
+    out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    out.append(val);
+}
+
+template <>
+inline bool radix_deserialize<std::string>(const char *&p, const char *end, std::string &val)
+{
+    unsigned int len;
+    if (!radix_deserialize(p, end, len) || (unsigned long)(end - p) < len)
+        return false;
+    val.assign(p, len);
+    p += len;
+    return true;
+}
+#endif //RADIX_SERIALIZE
@@ -0,0 +1,277 @@
+#ifndef RADIX_STRING_SCANNER
+#define RADIX_STRING_SCANNER
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "radix_tree.h"
+
+/**
+ * @brief 由radix_tree<std::string, T>编译的多模式子串扫描器（Aho–Corasick）
+ * 状态为压缩边上的位置：每条边上的每个字符对应一个状态，边内的转移就是边的下一个字符，
+ * 只有在边的末尾才按首字符查找子节点。失败链接和输出链接在这些状态上计算，
+ * 一次从左到右扫描即可报告树中每个序列在文本中的每次出现。
+ * @note 扫描器引用树中边的序列并返回指向叶子的迭代器，树修改后需要重新编译；
+ *  空序列不参与匹配
+ */
+template <typename T>
+class radix_string_scanner
+{
+public:
+    typedef radix_tree<std::string, T> tree_type;
+    typedef typename tree_type::iterator iterator;
+    typedef std::size_t size_type;
+    /**
+     * @note first为匹配在文本中的结束位置（不含），起始位置为first - 序列长度
+     */
+    typedef std::pair<size_type, iterator> match_type;
+
+    //构造函数
+    explicit radix_string_scanner(tree_type &tree);
+
+    //成员函数
+    /**
+     * @brief 扫描text，按结束位置顺序返回所有匹配，同一位置先返回较长的序列
+     */
+    void scan(const std::string &text, std::vector<match_type> &vec) const;
+
+    /**
+     * @brief 流式扫描：保留上一块结束时的状态，跨越块边界的匹配不会丢失
+     * @note 结果中的位置从流的开头计算，vec中原有的内容会被清除
+     */
+    void feed(const char *data, size_type len, std::vector<match_type> &vec);
+
+    void feed(const std::string &chunk, std::vector<match_type> &vec)
+    {
+        feed(chunk.data(), chunk.size(), vec);
+    }
+
+    /**
+     * @brief 重置流式扫描的状态
+     */
+    void reset()
+    {
+        m_state = 0;
+        m_consumed = 0;
+    }
+
+    size_type state_count() const
+    {
+        return m_offset.size();
+    }
+
+private:
+    typedef radix_tree_node<std::string, T> node_type;
+    typedef typename node_type::iterator_child iterator_child;
+
+    static const int NONE = -1;
+
+    //状态所在边的字符序列及其在边中的下一个字符下标；状态0为根
+    std::vector<const std::string *> m_edge;
+    std::vector<int> m_offset;
+    //到达边末尾的状态的子节点：按首字符排序，保存在m_child_char/m_child_state的[m_child_begin, m_child_end)中
+    std::vector<int> m_child_begin;
+    std::vector<int> m_child_end;
+    std::vector<unsigned char> m_child_char;
+    std::vector<int> m_child_state;
+    std::vector<int> m_fail;
+    //m_output为在该状态结束的序列，m_dict为沿失败链接的下一个有输出的状态
+    std::vector<int> m_output;
+    std::vector<int> m_dict;
+    std::vector<iterator> m_leafs;
+    std::vector<int> m_length;
+
+    int m_state;
+    size_type m_consumed;
+
+    struct depth_less
+    {
+        const std::vector<int> &m_length;
+
+        explicit depth_less(const std::vector<int> &length) : m_length(length) {}
+
+        bool operator()(int a, int b) const
+        {
+            return m_length[a] < m_length[b];
+        }
+    };
+
+    /**
+     * @brief 为node的边建立状态，返回边上首个字符的状态
+     */
+    int add_node(node_type *node, std::deque<std::pair<node_type *, int> > &queue);
+
+    /**
+     * @brief 状态s读入字符c的转移，不存在时返回NONE
+     */
+    int next(int s, char c) const;
+
+    /**
+     * @brief 从状态s开始读入c，沿失败链接直到存在转移或回到根
+     */
+    int step(int s, char c) const;
+
+    void report(int s, size_type end, std::vector<match_type> &vec) const;
+};
+
+template <typename T>
+const int radix_string_scanner<T>::NONE;
+
+template <typename T>
+radix_string_scanner<T>::radix_string_scanner(tree_type &tree) : m_state(0), m_consumed(0)
+{
+    //根状态
+    static const std::string empty;
+    m_edge.push_back(&empty);
+    m_offset.push_back(0);
+    m_child_begin.push_back(0);
+    m_child_end.push_back(0);
+    m_output.push_back(NONE);
+    m_length.push_back(0);
+    if (tree.m_root == NULL)
+    {
+        m_fail.push_back(0);
+        m_dict.push_back(NONE);
+        return;
+    }
+
+    //按层次建立状态，保证所有子节点的状态晚于父节点，便于按序计算失败链接
+    std::deque<std::pair<node_type *, int> > queue;
+    queue.push_back(std::make_pair(tree.m_root, 0));
+    while (!queue.empty())
+    {
+        node_type *node = queue.front().first;
+        int last = queue.front().second;
+        queue.pop_front();
+
+        iterator_child it;
+        m_child_begin[last] = m_child_char.size();
+        for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        {
+            if (it->second->m_is_leaf)
+            {
+                if (last != 0)
+                {
+                    m_output[last] = m_leafs.size();
+                    m_leafs.push_back(iterator(it->second));
+                }
+                continue;
+            }
+            m_child_char.push_back(static_cast<unsigned char>(it->first[0]));
+            m_child_state.push_back(add_node(it->second, queue));
+        }
+        m_child_end[last] = m_child_char.size();
+    }
+
+    //按深度递增的顺序计算，失败状态的深度更小，处理到s时其失败链已经确定
+    m_fail.assign(m_offset.size(), 0);
+    m_dict.assign(m_offset.size(), NONE);
+    std::vector<int> order(m_offset.size());
+    for (size_type s = 0; s < order.size(); s++)
+        order[s] = s;
+    std::stable_sort(order.begin(), order.end(), depth_less(m_length));
+
+    for (size_type i = 0; i < order.size(); i++)
+    {
+        int s = order[i];
+        int f = m_fail[s];
+        m_dict[s] = (m_output[f] != NONE) ? f : m_dict[f];
+        //所有后继状态t = next(s, c)的失败状态为step(fail(s), c)
+        if (m_offset[s] < static_cast<int>(m_edge[s]->size()))
+        {
+            char c = (*m_edge[s])[m_offset[s]];
+            m_fail[s + 1] = (s == 0) ? 0 : step(f, c);
+        }
+        else
+        {
+            for (int j = m_child_begin[s]; j < m_child_end[s]; j++)
+                m_fail[m_child_state[j]] = (s == 0) ? 0 : step(f, m_child_char[j]);
+        }
+    }
+}
+
+template <typename T>
+int radix_string_scanner<T>::add_node(node_type *node, std::deque<std::pair<node_type *, int> > &queue)
+{
+    //边上第i个字符（从1开始）对应状态first + i - 1，其下一个字符下标为i
+    int first = m_offset.size();
+    int len = node->m_key.size();
+    for (int i = 1; i <= len; i++)
+    {
+        m_edge.push_back(&node->m_key);
+        m_offset.push_back(i);
+        m_child_begin.push_back(0);
+        m_child_end.push_back(0);
+        m_output.push_back(NONE);
+        m_length.push_back(node->m_depth + i);
+    }
+    queue.push_back(std::make_pair(node, first + len - 1));
+    return first;
+}
+
+template <typename T>
+int radix_string_scanner<T>::next(int s, char c) const
+{
+    const std::string &edge = *m_edge[s];
+    int offset = m_offset[s];
+    if (offset < static_cast<int>(edge.size()))
+        return edge[offset] == c ? s + 1 : NONE;
+
+    //边的末尾，在有序的子节点首字符中二分查找，std::string按无符号字符排序
+    unsigned char u = static_cast<unsigned char>(c);
+    std::vector<unsigned char>::const_iterator begin = m_child_char.begin() + m_child_begin[s];
+    std::vector<unsigned char>::const_iterator end = m_child_char.begin() + m_child_end[s];
+    std::vector<unsigned char>::const_iterator it = std::lower_bound(begin, end, u);
+    if (it == end || *it != u)
+        return NONE;
+    return m_child_state[it - m_child_char.begin()];
+}
+
+template <typename T>
+int radix_string_scanner<T>::step(int s, char c) const
+{
+    while (true)
+    {
+        int t = next(s, c);
+        if (t != NONE)
+            return t;
+        if (s == 0)
+            return 0;
+        s = m_fail[s];
+    }
+}
+
+template <typename T>
+void radix_string_scanner<T>::report(int s, size_type end, std::vector<match_type> &vec) const
+{
+    if (m_output[s] == NONE)
+        s = m_dict[s];
+    for (; s != NONE; s = m_dict[s])
+        vec.push_back(match_type(end, m_leafs[m_output[s]]));
+}
+
+template <typename T>
+void radix_string_scanner<T>::scan(const std::string &text, std::vector<match_type> &vec) const
+{
+    vec.clear();
+    int s = 0;
+    for (size_type i = 0; i < text.size(); i++)
+    {
+        s = step(s, text[i]);
+        report(s, i + 1, vec);
+    }
+}
+
+template <typename T>
+void radix_string_scanner<T>::feed(const char *data, size_type len, std::vector<match_type> &vec)
+{
+    vec.clear();
+    for (size_type i = 0; i < len; i++)
+    {
+        m_state = step(m_state, data[i]);
+        report(m_state, m_consumed + i + 1, vec);
+    }
+    m_consumed += len;
+}
+#endif //RADIX_STRING_SCANNER
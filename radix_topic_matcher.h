@@ -0,0 +1,172 @@
+#ifndef RADIX_TOPIC_MATCHER
+#define RADIX_TOPIC_MATCHER
+
+#include <string>
+#include <vector>
+#include "radix_tree.h"
+
+/**
+ * @brief 基于radix_tree<std::string, T>的订阅主题匹配（MQTT风格）
+ * 树中存储的key为订阅模式，由分隔符划分层级，其中：
+ *  -单层通配符（默认'+'）占据一整层，匹配主题中的任意一层
+ *  -多层通配符（默认'#'）只能是模式的最后一层，匹配剩余的任意层，包括零层，
+ *   即"a/#"同时匹配"a"
+ * 通配符只在层级开头生效，匹配时沿压缩边逐字符前进，在每个节点处只进入首字符为主题
+ * 当前字符或通配符的子节点，因此代价与能够匹配的订阅路径成正比，而非订阅总数。
+ */
+template <typename T>
+class radix_topic_matcher
+{
+public:
+    typedef radix_tree<std::string, T> tree_type;
+    typedef typename tree_type::iterator iterator;
+
+    //构造函数
+    /**
+     * @par tree 订阅模式所在的树，匹配器只保存引用，树的修改对后续匹配立即可见
+     */
+    radix_topic_matcher(tree_type &tree, char separator = '/', char single = '+', char multi = '#')
+        : m_tree(tree), m_separator(separator), m_single(single), m_multi(multi) {}
+
+    //成员函数
+    /**
+     * @brief 返回树中能够匹配具体主题topic的所有模式，结果按序排列
+     */
+    void match(const std::string &topic, std::vector<iterator> &vec) const;
+
+private:
+    typedef radix_tree_node<std::string, T> node_type;
+    typedef typename node_type::iterator_child iterator_child;
+
+    tree_type &m_tree;
+    char m_separator;
+    char m_single;
+    char m_multi;
+
+    /**
+     * @brief 从node->m_key的第offset个字符、主题的第pos个字符开始继续匹配
+     * @par level_start 当前位置是否为模式中一层的开头
+     * @par parent_level 主题已经结束，模式中的分隔符是为匹配"a/#"而虚拟消耗的
+     */
+    void walk(node_type *node, std::size_t offset, const std::string &topic, std::size_t pos,
+              bool level_start, bool parent_level, std::vector<iterator> &vec) const;
+
+    /**
+     * @brief 在node中查找首字符为c的内部子节点
+     */
+    static iterator_child find_child(node_type *node, char c);
+
+    static bool child_less(const iterator_child &a, const iterator_child &b)
+    {
+        return a->first < b->first;
+    }
+};
+
+template <typename T>
+void radix_topic_matcher<T>::match(const std::string &topic, std::vector<iterator> &vec) const
+{
+    vec.clear();
+    if (m_tree.m_root == NULL)
+        return;
+    walk(m_tree.m_root, 0, topic, 0, true, false, vec);
+}
+
+template <typename T>
+void radix_topic_matcher<T>::walk(node_type *node, std::size_t offset, const std::string &topic, std::size_t pos,
+                                  bool level_start, bool parent_level, std::vector<iterator> &vec) const
+{
+    //沿压缩边逐字符匹配
+    const std::string &edge = node->m_key;
+    while (offset < edge.size())
+    {
+        char c = edge[offset];
+        if (level_start && c == m_multi)
+        {
+            //多层通配符必须是模式的最后一个字符，匹配主题的剩余部分
+            if (offset + 1 != edge.size())
+                return;
+            iterator_child leaf = node->m_children.find(std::string());
+            if (leaf != node->m_children.end())
+                vec.push_back(iterator(leaf->second));
+            return;
+        }
+        if (level_start && c == m_single && !parent_level)
+        {
+            //单层通配符匹配主题中当前层的全部字符
+            std::size_t end = topic.find(m_separator, pos);
+            pos = (end == std::string::npos) ? topic.size() : end;
+            level_start = false;
+            offset++;
+            continue;
+        }
+        if (pos == topic.size())
+        {
+            //主题已结束，只有"sep#"形式的后缀还可能匹配父层
+            if (c != m_separator || parent_level)
+                return;
+            parent_level = true;
+            level_start = true;
+            offset++;
+            continue;
+        }
+        if (parent_level || c != topic[pos])
+            return;
+        level_start = (c == m_separator);
+        offset++;
+        pos++;
+    }
+
+    //到达节点末尾，主题已结束时检查叶子节点
+    if (pos == topic.size() && !parent_level)
+    {
+        iterator_child leaf = node->m_children.find(std::string());
+        if (leaf != node->m_children.end())
+            vec.push_back(iterator(leaf->second));
+    }
+
+    //只进入可能匹配的子节点：主题的下一个字符、通配符、或主题结束时的分隔符
+    char candidates[4];
+    int count = 0;
+    if (pos < topic.size() && !parent_level)
+        candidates[count++] = topic[pos];
+    else if (pos == topic.size() && !parent_level)
+        candidates[count++] = m_separator;
+    if (level_start)
+    {
+        if (!parent_level)
+            candidates[count++] = m_single;
+        candidates[count++] = m_multi;
+    }
+
+    //按子节点顺序插入，使结果保持有序；不同候选字符可能命中同一子节点
+    iterator_child children[4];
+    int num = 0;
+    for (int i = 0; i < count; i++)
+    {
+        iterator_child it = find_child(node, candidates[i]);
+        if (it == node->m_children.end())
+            continue;
+        int j = 0;
+        while (j < num && child_less(children[j], it))
+            j++;
+        if (j < num && children[j] == it)
+            continue;
+        for (int k = num; k > j; k--)
+            children[k] = children[k - 1];
+        children[j] = it;
+        num++;
+    }
+
+    for (int i = 0; i < num; i++)
+        walk(children[i]->second, 0, topic, pos, level_start, parent_level, vec);
+}
+
+template <typename T>
+typename radix_topic_matcher<T>::iterator_child radix_topic_matcher<T>::find_child(node_type *node, char c)
+{
+    iterator_child it = node->m_children.lower_bound(std::string(1, c));
+    if (it != node->m_children.end() && !it->first.empty() && it->first[0] == c)
+        return it;
+    return node->m_children.end();
+}
+#endif //RADIX_TOPIC_MATCHER
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <cassert>
+#include <atomic>
+#include <new>
 #include "radix_tree_it.h"
 #include "radix_tree_node.h"
 
@@ -44,6 +46,9 @@ inline int radix_length<std::string>(const std::string &key)
 template <typename K, typename T>
 class radix_tree
 {
+    friend class radix_topic_matcher<T>;
+    friend class radix_string_scanner<T>;
+
 public:
     typedef K key_type;
     typedef T mapped_type;
@@ -52,10 +57,25 @@ public:
     typedef std::size_t size_type;
 
     //构造函数
-    radix_tree() : m_size(0), m_root(NULL) {}
+    radix_tree() : m_size(0), m_root(NULL), m_generation(0), m_pools(), m_free_pools(), m_compacting(false), m_compact_pass(0),
+                   m_node_fill(-1), m_value_fill(-1), m_compact_node(NULL), m_compact_key(), m_compact_leaf(false), m_compact_generation(0) {}
+    radix_tree(const radix_tree &r) : m_size(0), m_root(NULL), m_generation(0), m_pools(), m_free_pools(), m_compacting(false), m_compact_pass(0),
+                                      m_node_fill(-1), m_value_fill(-1), m_compact_node(NULL), m_compact_key(), m_compact_leaf(false), m_compact_generation(0)
+    {
+        merge(r);
+    }
+    radix_tree &operator=(const radix_tree &r)
+    {
+        if (this != &r)
+        {
+            clear();
+            merge(r);
+        }
+        return *this;
+    }
     ~radix_tree()
     {
-        delete m_root;
+        clear();
     }
 
     //成员函数
@@ -80,11 +100,43 @@ public:
      */
     void clear()
     {
-        delete m_root;
+        m_compacting = false;
+        if (m_root != NULL)
+            destroy_node(m_root);
         m_root = NULL;
         m_size = 0;
+        m_generation++;
+    }
+
+    /**
+     * @brief 返回树的结构版本号，插入、删除和节点合并时递增
+     * @note 版本号不变时，之前查找得到的迭代器与匹配结果仍然有效，可供缓存判断失效
+     */
+    unsigned long generation() const
+    {
+        return m_generation.load(std::memory_order_acquire);
     }
 
+    /**
+     * @brief 按深度优先顺序将所有节点和值迁移到连续的内存块中，释放原有的零散内存
+     * @note 使所有迭代器失效，并递增结构版本号
+     */
+    void compact()
+    {
+        while (!compact_step(static_cast<size_type>(-1)))
+            ;
+    }
+
+    /**
+     * @brief 增量整理：每次调用最多访问budget个节点，多次调用完成一次compact
+     * 两次调用之间可以修改树：游标保存为下一个节点的路径，结构修改后按路径重新定位，
+     * 已经迁移的节点不会再次访问。游标之后新建的节点在遍历到时迁移，游标之前新建的节点
+     * 留到下一次整理。
+     * @note 迁移了节点的调用使所有迭代器失效，并递增结构版本号
+     * @return 本次整理完成时返回true
+     */
+    bool compact_step(size_type budget);
+
     /**
      * @brief 返回树中首个元素的迭代器，树为空时返回空的迭代器
      */
@@ -106,6 +158,20 @@ public:
      */
     iterator longest_match(const K &key);
 
+    /**
+     * @brief 由短到长依次访问树中所有能够前缀匹配key的叶子节点，只沿key向下查找一次
+     * @par visitor 可调用对象，参数为iterator，返回false时提前结束
+     * @return 访问结束后的visitor，与std::for_each相同
+     * @note 包括与key完全相同的元素
+     */
+    template <typename F>
+    F all_prefixes_of(const K &key, F visitor);
+
+    /**
+     * @brief 由短到长将树中所有能够前缀匹配key的叶子节点添加到vec中
+     */
+    void all_prefixes_of(const K &key, std::vector<iterator> &vec);
+
     /**
      * @brief 在树中寻找key能够前缀匹配的所有叶子节点
      * @note 匹配结果长度大于key
@@ -143,9 +209,130 @@ public:
      */
     bool erase(const K &key);
 
+    /**
+     * @brief 将other中的元素并入本树，两树中都存在的序列保留本树的值
+     * @note 两棵树按子节点的有序map同步遍历，本树中不存在的子树由copy_subtree逐节点复制，
+     * 不逐个查找叶子节点，但也不会把other的节点直接接入本树。
+     * 两棵独立的树无法判断子树是否相同，同时存在的叶子节点总会被访问，
+     * 开销与两树的公共部分成正比
+     */
+    void merge(const radix_tree &other);
+
+    /**
+     * @brief 将other中的元素并入本树，两树中都存在的序列调用resolve(mine, theirs)处理冲突
+     * @par resolve 可调用对象，参数为本树中的T&和other中的const T&，结果写回mine
+     */
+    template <typename F>
+    void merge(const radix_tree &other, F resolve);
+
+    /**
+     * @brief 只保留本树中同时存在于other中的序列，值保持不变
+     * @note other中不存在的子树整体删除，两树中都存在的叶子节点逐个访问
+     */
+    void intersect(const radix_tree &other);
+
+    /**
+     * @brief 删除本树中同时存在于other中的序列
+     * @note other中不存在的子树直接跳过，不访问其叶子节点；两树中都存在的叶子节点逐个访问
+     */
+    void difference(const radix_tree &other);
+
+    /**
+     * @brief 比较本树（旧）与other（新）的差异，结果均按序列顺序排列
+     * @par added other中新增的元素，迭代器指向other
+     * @par removed other中已删除的元素，迭代器指向本树
+     * @par changed 两树中值不同的元素，first指向本树，second指向other，要求T重载==
+     * @note 只有一棵树中存在的子树整体收集；两树中都存在的叶子节点总会被访问并比较值，
+     * 节点上没有子树摘要，无法跳过内容相同的子树
+     */
+    void diff(const radix_tree &other, std::vector<iterator> &added, std::vector<iterator> &removed,
+              std::vector<std::pair<iterator, iterator> > &changed);
+
 private:
     size_type m_size;
     radix_tree_node<K, T> *m_root;
+    std::atomic<unsigned long> m_generation;
+
+    /**
+     * @brief compact使用的连续内存块，存放POOL_SIZE个节点或POOL_SIZE个值，按迁移顺序依次填充
+     * 节点块与值块分别填充，值块的个数由实际迁移的叶子数决定。
+     * @note 块中的元素全部释放后立即归还内存，其在m_pools中的下标进入m_free_pools复用
+     */
+    struct node_pool
+    {
+        char *m_data;
+        size_type m_used;
+        size_type m_live;
+        //创建该块的整理编号
+        unsigned long m_pass;
+    };
+
+    static const size_type POOL_SIZE = 1024;
+
+    std::vector<node_pool> m_pools;
+    std::vector<int> m_free_pools;
+    bool m_compacting;
+    //本次整理的编号，所在块由本次整理创建的节点已经迁移
+    unsigned long m_compact_pass;
+    //正在填充的节点块与值块，-1表示没有
+    int m_node_fill;
+    int m_value_fill;
+    //游标：下一个要访问的节点，及其路径与是否为叶子，用于树修改后重新定位
+    radix_tree_node<K, T> *m_compact_node;
+    K m_compact_key;
+    bool m_compact_leaf;
+    unsigned long m_compact_generation;
+
+    /**
+     * @brief 释放node为根的子树，内存块中的节点只析构，并在块为空时释放块
+     */
+    void destroy_node(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 新建可存放POOL_SIZE个大小为size的元素的内存块，返回其下标
+     */
+    int new_pool(size_type size);
+
+    /**
+     * @brief 减少内存块id中的存活计数，为空时释放
+     */
+    void release_pool(int id);
+
+    /**
+     * @brief node是否已在本次整理中迁移
+     */
+    bool relocated(const radix_tree_node<K, T> *node) const
+    {
+        return node->m_pool >= 0 && m_pools[node->m_pool].m_pass == m_compact_pass;
+    }
+
+    /**
+     * @brief 将node及其值复制到当前内存块，修正父子链接后释放原节点
+     * @return 迁移后的节点
+     */
+    radix_tree_node<K, T> *relocate(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 先序遍历中node的下一个节点，不存在时返回NULL
+     */
+    static radix_tree_node<K, T> *next_preorder(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 先序遍历中node为根的子树之后的第一个节点，不存在时返回NULL
+     */
+    static radix_tree_node<K, T> *skip_subtree(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 先序遍历中不早于位置(key, leaf)的第一个节点，不存在时返回NULL
+     * @par key 节点的完整路径
+     * @par leaf 同一路径上叶子排在内部节点之后
+     */
+    radix_tree_node<K, T> *seek_preorder(const K &key, bool leaf) const;
+
+    /**
+     * @brief 从根到node的完整路径
+     */
+    static K node_path(const radix_tree_node<K, T> *node);
 
     /**
      * @brief 在以node为根节点的树中查找key的最长前缀匹配序列对应节点
@@ -199,6 +386,84 @@ private:
      * @par node为父节点唯一内部节点
      */
     void merge_node(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 在node的前count个元素处将其拆分，公共前缀作为新的父节点
+     * @return 新建的父节点
+     */
+    static radix_tree_node<K, T> *split_node(radix_tree_node<K, T> *node, int count);
+
+    /**
+     * @brief 在parent中查找首元素等于key[pos]的内部子节点，不存在时返回NULL
+     */
+    static radix_tree_node<K, T> *find_child(radix_tree_node<K, T> *parent, const K &key, int pos);
+
+    /**
+     * @brief 统计以node为根的子树中的叶子节点个数
+     */
+    static size_type count_leafs(radix_tree_node<K, T> *node);
+
+    /**
+     * @brief 将src从第offset个元素开始的子树复制为parent的子节点
+     * @return 新建的子树根节点
+     */
+    radix_tree_node<K, T> *copy_subtree(radix_tree_node<K, T> *src, int offset, radix_tree_node<K, T> *parent);
+
+    /**
+     * @brief 将other树中(b, ob)位置之后的子树并入a节点之下
+     * @par a 本树的内部节点，a的末尾与(b, ob)对应相同的序列
+     * @par ob b->m_key中已经匹配的元素个数
+     */
+    template <typename F>
+    void merge_at(radix_tree_node<K, T> *a, radix_tree_node<K, T> *b, int ob, F &resolve);
+
+    /**
+     * @brief 同步遍历两棵树，(a, oa)与(b, ob)对应相同的序列
+     * @par both 两树中都存在的叶子节点对
+     * @par only_a 只存在于a树的子树根节点，其子树不再访问
+     * @par only_b 只存在于b树的子树根节点，其子树不再访问
+     */
+    static void lockstep(radix_tree_node<K, T> *a, int oa, radix_tree_node<K, T> *b, int ob,
+                         std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> > &both,
+                         std::vector<radix_tree_node<K, T> *> &only_a, std::vector<radix_tree_node<K, T> *> &only_b);
+
+    /**
+     * @brief longest_match所用的访问器，记录最后一个前缀
+     */
+    struct last_prefix
+    {
+        radix_tree_node<K, T> *m_node;
+
+        last_prefix() : m_node(NULL) {}
+        bool operator()(iterator it)
+        {
+            m_node = it.m_pointer;
+            return true;
+        }
+    };
+
+    /**
+     * @brief all_prefixes_of所用的访问器，将前缀依次添加到vec中
+     */
+    struct collect_prefix
+    {
+        std::vector<iterator> &m_vec;
+
+        collect_prefix(std::vector<iterator> &vec) : m_vec(vec) {}
+        bool operator()(iterator it)
+        {
+            m_vec.push_back(it);
+            return true;
+        }
+    };
+
+    /**
+     * @brief merge的默认冲突处理，保留本树的值
+     */
+    struct keep_mine
+    {
+        void operator()(T &, const T &) const {}
+    };
 };
 
 template <typename K, typename T>
@@ -225,43 +490,371 @@ void radix_tree<K, T>::prefix_match(const K &key, std::vector<iterator> &vec)
     int len_prefix = radix_length(key) - node->m_depth;
     K key_sub = radix_substr(key, node->m_depth, len_prefix);
     K node_key_sub = radix_substr(node->m_key, 0, len_prefix);
-    if (key_sub != node_key_sub)
+    if (!(key_sub == node_key_sub))
         return;
     get_leafs(node, vec);
 }
 
 template <typename K, typename T>
 typename radix_tree<K, T>::iterator radix_tree<K, T>::longest_match(const K &key)
+{
+    //沿key向下查找时记录最后一个叶子节点，不再沿父节点回溯
+    return iterator(all_prefixes_of(key, last_prefix()).m_node);
+}
+
+template <typename K, typename T>
+template <typename F>
+F radix_tree<K, T>::all_prefixes_of(const K &key, F visitor)
 {
     if (m_root == NULL)
-        return iterator(NULL);
-    radix_tree_node<K, T> *node = get_longest_prefix_node(key, m_root, 0);
-    if (node->m_is_leaf)
-        return iterator(node);
+        return visitor;
 
-    bool node_has_diff = !(node->m_key == radix_substr(key, node->m_depth, radix_length(node->m_key)));
-    //node父节点与key一定没有不同后缀
-    if (node_has_diff)
+    int len = radix_length(key);
+    int matched = 0;
+    radix_tree_node<K, T> *node = m_root;
+    while (true)
     {
-        node = node->m_parent;
-        node_has_diff = !(node->m_key == radix_substr(key, node->m_depth, radix_length(node->m_key)));
-        assert(node_has_diff == false);
+        //空序列在子节点中排在最前，叶子节点只可能是首个子节点
+        typename radix_tree_node<K, T>::iterator_child it = node->m_children.begin();
+        if (it != node->m_children.end() && it->second->m_is_leaf)
+            if (!visitor(iterator(it->second)))
+                return visitor;
+        if (matched == len)
+            return visitor;
+
+        radix_tree_node<K, T> *child = find_child(node, key, matched);
+        if (child == NULL)
+            return visitor;
+
+        //逐个元素比较，避免截取子序列
+        int len_child = radix_length(child->m_key);
+        if (matched + len_child > len)
+            return visitor;
+        for (int i = 1; i < len_child; i++)
+            if (!(child->m_key[i] == key[matched + i]))
+                return visitor;
+        node = child;
+        matched += len_child;
     }
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::all_prefixes_of(const K &key, std::vector<iterator> &vec)
+{
+    vec.clear();
+    all_prefixes_of(key, collect_prefix(vec));
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::merge(const radix_tree &other)
+{
+    merge(other, keep_mine());
+}
+
+template <typename K, typename T>
+template <typename F>
+void radix_tree<K, T>::merge(const radix_tree &other, F resolve)
+{
+    if (this == &other || other.m_root == NULL)
+        return;
+    if (m_root == NULL)
+    {
+        m_root = new radix_tree_node<K, T>();
+        m_root->m_key = other.m_root->m_key;
+    }
+    merge_at(m_root, other.m_root, 0, resolve);
+}
 
-    K nul = radix_substr(key, 0, 0);
-    while (node != NULL)
+template <typename K, typename T>
+void radix_tree<K, T>::intersect(const radix_tree &other)
+{
+    if (this == &other || m_root == NULL)
+        return;
+    if (other.m_root == NULL)
     {
-        typename radix_tree_node<K, T>::iterator_child it = node->m_children.find(nul);
-        if (it != node->m_children.end())
+        clear();
+        return;
+    }
+
+    std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> > both;
+    std::vector<radix_tree_node<K, T> *> only_a, only_b;
+    lockstep(m_root, 0, other.m_root, 0, both, only_a, only_b);
+
+    //只存在于本树的子树互不相交，删除其中一棵不会释放其余子树的节点
+    typename std::vector<radix_tree_node<K, T> *>::iterator it;
+    for (it = only_a.begin(); it != only_a.end(); ++it)
+        erase(*it);
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::difference(const radix_tree &other)
+{
+    if (this == &other)
+    {
+        clear();
+        return;
+    }
+    if (m_root == NULL || other.m_root == NULL)
+        return;
+
+    std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> > both;
+    std::vector<radix_tree_node<K, T> *> only_a, only_b;
+    lockstep(m_root, 0, other.m_root, 0, both, only_a, only_b);
+
+    typename std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> >::iterator it;
+    for (it = both.begin(); it != both.end(); ++it)
+        erase(it->first);
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::diff(const radix_tree &other, std::vector<iterator> &added, std::vector<iterator> &removed,
+                            std::vector<std::pair<iterator, iterator> > &changed)
+{
+    added.clear();
+    removed.clear();
+    changed.clear();
+    if (this == &other)
+        return;
+    if (m_root == NULL || other.m_root == NULL)
+    {
+        if (m_root != NULL)
+            get_leafs(m_root, removed);
+        if (other.m_root != NULL)
+            get_leafs(other.m_root, added);
+        return;
+    }
+
+    std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> > both;
+    std::vector<radix_tree_node<K, T> *> only_a, only_b;
+    lockstep(m_root, 0, other.m_root, 0, both, only_a, only_b);
+
+    typename std::vector<radix_tree_node<K, T> *>::iterator it;
+    for (it = only_a.begin(); it != only_a.end(); ++it)
+        get_leafs(*it, removed);
+    for (it = only_b.begin(); it != only_b.end(); ++it)
+        get_leafs(*it, added);
+
+    typename std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> >::iterator it_both;
+    for (it_both = both.begin(); it_both != both.end(); ++it_both)
+        if (!(it_both->first->m_value->second == it_both->second->m_value->second))
+            changed.push_back(std::pair<iterator, iterator>(it_both->first, it_both->second));
+}
+
+template <typename K, typename T>
+template <typename F>
+void radix_tree<K, T>::merge_at(radix_tree_node<K, T> *a, radix_tree_node<K, T> *b, int ob, F &resolve)
+{
+    assert(a->m_is_leaf == false);
+    int len_b = radix_length(b->m_key);
+
+    //b节点的key还有未匹配部分，在a的子节点中继续匹配
+    if (ob < len_b)
+    {
+        radix_tree_node<K, T> *child = find_child(a, b->m_key, ob);
+        if (child == NULL)
         {
-            assert(it->second->m_is_leaf == true);
-            assert(radix_substr(key, node->m_depth, radix_length(node->m_key)) == node->m_key);
-            return iterator(it->second);
+            copy_subtree(b, ob, a);
+            return;
         }
-        node = node->m_parent;
+
+        int len_child = radix_length(child->m_key);
+        int count = 0;
+        while (count < len_child && ob + count < len_b && child->m_key[count] == b->m_key[ob + count])
+            count++;
+        //b在child的key中间分叉或结束，拆分child使两树在节点末尾对齐
+        if (count < len_child)
+            child = split_node(child, count);
+        merge_at(child, b, ob + count, resolve);
+        return;
     }
 
-    return iterator(NULL);
+    //a和b在节点末尾对齐，逐个合并b的子节点
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = b->m_children.begin(); it != b->m_children.end(); ++it)
+    {
+        if (!it->second->m_is_leaf)
+        {
+            merge_at(a, it->second, 0, resolve);
+            continue;
+        }
+
+        typename radix_tree_node<K, T>::iterator_child it_a = a->m_children.find(it->first);
+        if (it_a == a->m_children.end())
+            copy_subtree(it->second, 0, a);
+        else
+            resolve(it_a->second->m_value->second, it->second->m_value->second);
+    }
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::lockstep(radix_tree_node<K, T> *a, int oa, radix_tree_node<K, T> *b, int ob,
+                                std::vector<std::pair<radix_tree_node<K, T> *, radix_tree_node<K, T> *> > &both,
+                                std::vector<radix_tree_node<K, T> *> &only_a, std::vector<radix_tree_node<K, T> *> &only_b)
+{
+    int len_a = radix_length(a->m_key);
+    int len_b = radix_length(b->m_key);
+    while (oa < len_a && ob < len_b && a->m_key[oa] == b->m_key[ob])
+    {
+        oa++;
+        ob++;
+    }
+
+    typename radix_tree_node<K, T>::iterator_child it_a, it_b;
+
+    //两节点的key出现不同元素，其子树不相交
+    if (oa < len_a && ob < len_b)
+    {
+        only_a.push_back(a);
+        only_b.push_back(b);
+        return;
+    }
+
+    //b节点先结束，在b的子节点中继续匹配a的剩余部分
+    if (oa < len_a)
+    {
+        bool matched = false;
+        for (it_b = b->m_children.begin(); it_b != b->m_children.end(); ++it_b)
+        {
+            if (!it_b->second->m_is_leaf && it_b->first[0] == a->m_key[oa])
+            {
+                lockstep(a, oa, it_b->second, 0, both, only_a, only_b);
+                matched = true;
+            }
+            else
+                only_b.push_back(it_b->second);
+        }
+        if (!matched)
+            only_a.push_back(a);
+        return;
+    }
+
+    //a节点先结束，在a的子节点中继续匹配b的剩余部分
+    if (ob < len_b)
+    {
+        bool matched = false;
+        for (it_a = a->m_children.begin(); it_a != a->m_children.end(); ++it_a)
+        {
+            if (!it_a->second->m_is_leaf && it_a->first[0] == b->m_key[ob])
+            {
+                lockstep(it_a->second, 0, b, ob, both, only_a, only_b);
+                matched = true;
+            }
+            else
+                only_a.push_back(it_a->second);
+        }
+        if (!matched)
+            only_b.push_back(b);
+        return;
+    }
+
+    //两节点同时结束，按有序map归并子节点，首元素相同的子节点继续同步遍历
+    it_a = a->m_children.begin();
+    it_b = b->m_children.begin();
+    while (it_a != a->m_children.end() && it_b != b->m_children.end())
+    {
+        bool nul_a = radix_length(it_a->first) == 0;
+        bool nul_b = radix_length(it_b->first) == 0;
+        if (nul_a && nul_b)
+        {
+            both.push_back(std::make_pair(it_a->second, it_b->second));
+            ++it_a;
+            ++it_b;
+        }
+        else if (!nul_a && !nul_b && it_a->first[0] == it_b->first[0])
+        {
+            lockstep(it_a->second, 0, it_b->second, 0, both, only_a, only_b);
+            ++it_a;
+            ++it_b;
+        }
+        else if (nul_a || (!nul_b && it_a->first < it_b->first))
+        {
+            only_a.push_back(it_a->second);
+            ++it_a;
+        }
+        else
+        {
+            only_b.push_back(it_b->second);
+            ++it_b;
+        }
+    }
+    for (; it_a != a->m_children.end(); ++it_a)
+        only_a.push_back(it_a->second);
+    for (; it_b != b->m_children.end(); ++it_b)
+        only_b.push_back(it_b->second);
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::split_node(radix_tree_node<K, T> *node, int count)
+{
+    int len = radix_length(node->m_key);
+    assert(count > 0 && count < len);
+
+    //在node的父节点中移除node节点
+    node->m_parent->m_children.erase(node->m_key);
+
+    //在node原有位置新建公共前缀序列节点
+    K key = radix_substr(node->m_key, 0, count);
+    radix_tree_node<K, T> *p = new radix_tree_node<K, T>();
+    p->m_key = key;
+    p->m_depth = node->m_depth;
+    p->m_is_leaf = false;
+    p->m_parent = node->m_parent;
+    p->m_parent->m_children[key] = p;
+
+    //重构node节点的key
+    node->m_parent = p;
+    node->m_depth += count;
+    node->m_key = radix_substr(node->m_key, count, len - count);
+    p->m_children[node->m_key] = node;
+    return p;
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::find_child(radix_tree_node<K, T> *parent, const K &key, int pos)
+{
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = parent->m_children.begin(); it != parent->m_children.end(); ++it)
+        if (!it->second->m_is_leaf && it->first[0] == key[pos])
+            return it->second;
+    return NULL;
+}
+
+template <typename K, typename T>
+typename radix_tree<K, T>::size_type radix_tree<K, T>::count_leafs(radix_tree_node<K, T> *node)
+{
+    if (node->m_is_leaf)
+        return 1;
+
+    size_type count = 0;
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        count += count_leafs(it->second);
+    return count;
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::copy_subtree(radix_tree_node<K, T> *src, int offset, radix_tree_node<K, T> *parent)
+{
+    radix_tree_node<K, T> *node;
+    if (src->m_is_leaf)
+    {
+        node = new radix_tree_node<K, T>(*src->m_value);
+        m_size++;
+        m_generation++;
+    }
+    else
+        node = new radix_tree_node<K, T>();
+
+    node->m_key = radix_substr(src->m_key, offset, radix_length(src->m_key) - offset);
+    node->m_depth = parent->m_depth + radix_length(parent->m_key);
+    node->m_is_leaf = src->m_is_leaf;
+    node->m_parent = parent;
+    parent->m_children[node->m_key] = node;
+
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = src->m_children.begin(); it != src->m_children.end(); ++it)
+        copy_subtree(it->second, 0, node);
+    return node;
 }
 
 template <typename K, typename T>
@@ -270,19 +863,23 @@ void radix_tree<K, T>::merge_node(radix_tree_node<K, T> *node)
     if (node == NULL)
         return;
     radix_tree_node<K, T> *parent = node->m_parent;
-    if (!node->m_is_leaf || parent == m_root || parent->m_children.size() != 1)
+    if (node->m_is_leaf || parent == m_root || parent->m_children.size() != 1)
         return;
 
+    //在祖父节点中移除node父节点
+    radix_tree_node<K, T> *grandparent = parent->m_parent;
+    grandparent->m_children.erase(parent->m_key);
+
     //重构node节点
-    node->m_key = radix_join(node->m_key, parent->m_key);
+    node->m_key = radix_join(parent->m_key, node->m_key);
     node->m_depth = parent->m_depth;
-    node->m_parent = parent->m_parent;
+    node->m_parent = grandparent;
+    grandparent->m_children[node->m_key] = node;
 
-    //删除node父节点
-    radix_tree_node<K, T> *grandparent = parent->m_parent;
-    typename radix_tree_node<K, T>::iterator_child it = grandparent->m_children.find(parent->m_key);
-    grandparent->m_children.erase(it);
-    delete parent;
+    //删除node父节点，先清空其子节点防止析构时删除node
+    parent->m_children.clear();
+    destroy_node(parent);
+    m_generation++;
 }
 
 template <typename K, typename T>
@@ -291,7 +888,7 @@ void radix_tree<K, T>::erase(iterator it)
     if (it == end())
         return;
 
-    radix_tree_node<K, T> *node = find(it->first, m_root, 0);
+    radix_tree_node<K, T> *node = it.m_pointer;
     assert(node->m_is_leaf == true);
     erase(node);
 }
@@ -299,6 +896,8 @@ void radix_tree<K, T>::erase(iterator it)
 template <typename K, typename T>
 bool radix_tree<K, T>::erase(const K &key)
 {
+    if (m_root == NULL)
+        return false;
     radix_tree_node<K, T> *node = get_longest_prefix_node(key, m_root, 0);
     if (!node->m_is_leaf)
         return false;
@@ -309,13 +908,13 @@ bool radix_tree<K, T>::erase(const K &key)
 template <typename K, typename T>
 void radix_tree<K, T>::erase(radix_tree_node<K, T> *node)
 {
-    assert(node->m_is_leaf == true);
-
     radix_tree_node<K, T> *parent = node->m_parent;
 
-    //删除node节点
+    //删除node节点及其子树
+    m_size -= count_leafs(node);
     parent->m_children.erase(node->m_key);
-    delete node;
+    destroy_node(node);
+    m_generation++;
 
     if (parent == m_root || parent->m_children.size() > 1)
     {
@@ -326,11 +925,10 @@ void radix_tree<K, T>::erase(radix_tree_node<K, T> *node)
     {
         erase(parent);
     }
-    //删除node后其父节点的子节点只剩一个节点
+    //删除node后其父节点的子节点只剩一个节点，若为内部节点则与父节点合并
     else if (parent->m_children.size() == 1)
     {
         typename radix_tree_node<K, T>::iterator_child it = parent->m_children.begin();
-        assert(it->second->m_is_leaf == false);
         merge_node(it->second);
     }
 }
@@ -370,6 +968,7 @@ std::pair<typename radix_tree<K, T>::iterator, bool> radix_tree<K, T>::insert(co
     else
     {
         m_size++;
+        m_generation++;
         //判断node是否有后缀来调用不同的构建方法
         bool node_is_prefix = (node->m_key == radix_substr(val.first, node->m_depth, radix_length(node->m_key)));
         if (node == m_root || node_is_prefix)
@@ -396,28 +995,12 @@ radix_tree_node<K, T> *radix_tree<K, T>::add_root(radix_tree_node<K, T> *node, c
     for (count = 0; count < len1 && count < len2; count++)
         if (node->m_key[count] != val.first[node->m_depth + count])
             break;
-    //统计node和val的diff
-    int len_diff_node = len1 - count;
+    //node和val存在公共前缀与不同后缀
     assert(count > 0);
-    assert(len_diff_node > 0);
-
-    //在node的父节点中移除node节点
-    node->m_parent->m_children.erase(node->m_key);
+    assert(count < len1);
 
     //在node原有位置新建公共前缀序列节点
-    K key = radix_substr(node->m_key, 0, count);
-    radix_tree_node<K, T> *p = new radix_tree_node<K, T>();
-    p->m_key = key;
-    p->m_depth = node->m_depth;
-    p->m_is_leaf = false;
-    p->m_parent = node->m_parent;
-    p->m_parent->m_children[key] = p;
-
-    //重构node节点的key
-    node->m_parent = p;
-    node->m_depth += count;
-    node->m_key = radix_substr(node->m_key, count, len_diff_node);
-    node->m_parent->m_children[node->m_key] = node;
+    radix_tree_node<K, T> *p = split_node(node, count);
 
     //添加val序列节点
     return add_child(p, val);
@@ -469,8 +1052,8 @@ typename radix_tree<K, T>::iterator radix_tree<K, T>::begin()
 {
     radix_tree_node<K, T> *node;
 
-    if (m_root == NULL)
-        return NULL;
+    if (m_root == NULL || m_root->m_children.empty())
+        return iterator(NULL);
     else
         node = begin(m_root);
 
@@ -552,4 +1135,227 @@ radix_tree_node<K, T> *radix_tree<K, T>::get_longest_prefix_node(const K &key, r
     //完全匹配时node不存在叶子节点，或者node的子节点无法匹配当前序列，返回node
     return node;
 }
+template <typename K, typename T>
+bool radix_tree<K, T>::compact_step(size_type budget)
+{
+    if (m_root == NULL)
+    {
+        m_compacting = false;
+        return true;
+    }
+
+    if (!m_compacting)
+    {
+        m_compacting = true;
+        m_compact_pass++;
+        m_node_fill = m_value_fill = -1;
+        m_compact_node = m_root;
+    }
+    else if (m_generation != m_compact_generation)
+    {
+        //两次调用之间树被修改，游标节点可能已被删除，按路径重新定位
+        m_compact_node = seek_preorder(m_compact_key, m_compact_leaf);
+    }
+
+    radix_tree_node<K, T> *node = m_compact_node;
+    for (; node != NULL && budget > 0; budget--)
+    {
+        if (!relocated(node))
+            node = relocate(node);
+        node = next_preorder(node);
+    }
+    m_compact_node = node;
+    m_compact_generation = m_generation;
+    if (node != NULL)
+    {
+        m_compact_key = node_path(node);
+        m_compact_leaf = node->m_is_leaf;
+        return false;
+    }
+
+    //部分填充的块留给之后的删除释放，下一次整理使用新的块
+    m_compacting = false;
+    m_node_fill = m_value_fill = -1;
+    return true;
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::destroy_node(radix_tree_node<K, T> *node)
+{
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it)
+        destroy_node(it->second);
+    node->m_children.clear();
+
+    if (node->m_value != NULL && node->m_value_pool >= 0)
+    {
+        node->m_value->~value_type();
+        node->m_value = NULL;
+        release_pool(node->m_value_pool);
+    }
+
+    int pool = node->m_pool;
+    if (pool < 0)
+        delete node;
+    else
+    {
+        node->~radix_tree_node<K, T>();
+        release_pool(pool);
+    }
+}
+
+template <typename K, typename T>
+int radix_tree<K, T>::new_pool(size_type size)
+{
+    int id;
+    if (m_free_pools.empty())
+    {
+        id = m_pools.size();
+        m_pools.push_back(node_pool());
+    }
+    else
+    {
+        id = m_free_pools.back();
+        m_free_pools.pop_back();
+    }
+
+    node_pool &pool = m_pools[id];
+    pool.m_data = static_cast<char *>(::operator new(POOL_SIZE * size));
+    pool.m_used = 0;
+    pool.m_live = 0;
+    pool.m_pass = m_compact_pass;
+    return id;
+}
+
+template <typename K, typename T>
+void radix_tree<K, T>::release_pool(int id)
+{
+    node_pool &pool = m_pools[id];
+    if (--pool.m_live > 0)
+        return;
+
+    //正在填充的块被清空时，之后的迁移改用新的块
+    if (id == m_node_fill)
+        m_node_fill = -1;
+    if (id == m_value_fill)
+        m_value_fill = -1;
+    ::operator delete(pool.m_data);
+    pool.m_data = NULL;
+    m_free_pools.push_back(id);
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::relocate(radix_tree_node<K, T> *node)
+{
+    if (m_node_fill < 0 || m_pools[m_node_fill].m_used == POOL_SIZE)
+        m_node_fill = new_pool(sizeof(radix_tree_node<K, T>));
+    node_pool &nodes = m_pools[m_node_fill];
+    radix_tree_node<K, T> *copy = new (nodes.m_data + nodes.m_used++ * sizeof(radix_tree_node<K, T>)) radix_tree_node<K, T>();
+    copy->m_pool = m_node_fill;
+    nodes.m_live++;
+
+    copy->m_key = node->m_key;
+    //重新插入子节点表，使其红黑树节点也按迁移顺序分配
+    copy->m_children.insert(node->m_children.begin(), node->m_children.end());
+    node->m_children.clear();
+    copy->m_parent = node->m_parent;
+    copy->m_depth = node->m_depth;
+    copy->m_is_leaf = node->m_is_leaf;
+    if (node->m_value != NULL)
+    {
+        if (m_value_fill < 0 || m_pools[m_value_fill].m_used == POOL_SIZE)
+            m_value_fill = new_pool(sizeof(value_type));
+        node_pool &values = m_pools[m_value_fill];
+        copy->m_value = new (values.m_data + values.m_used++ * sizeof(value_type)) value_type(*node->m_value);
+        copy->m_value_pool = m_value_fill;
+        values.m_live++;
+    }
+
+    //修正父子链接
+    typename radix_tree_node<K, T>::iterator_child it;
+    for (it = copy->m_children.begin(); it != copy->m_children.end(); ++it)
+        it->second->m_parent = copy;
+    if (node == m_root)
+        m_root = copy;
+    else
+        copy->m_parent->m_children[copy->m_key] = copy;
+
+    destroy_node(node);
+    m_generation++;
+    return copy;
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::next_preorder(radix_tree_node<K, T> *node)
+{
+    if (!node->m_children.empty())
+        return node->m_children.begin()->second;
+    return skip_subtree(node);
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::skip_subtree(radix_tree_node<K, T> *node)
+{
+    while (node->m_parent != NULL)
+    {
+        typename radix_tree_node<K, T>::iterator_child it = node->m_parent->m_children.find(node->m_key);
+        if (++it != node->m_parent->m_children.end())
+            return it->second;
+        node = node->m_parent;
+    }
+    return NULL;
+}
+
+template <typename K, typename T>
+radix_tree_node<K, T> *radix_tree<K, T>::seek_preorder(const K &key, bool leaf) const
+{
+    //先序即按(路径, 是否为叶子)的顺序：父节点的路径是子节点的前缀，兄弟节点按边有序
+    int len = radix_length(key);
+    radix_tree_node<K, T> *node = m_root;
+    while (true)
+    {
+        //此处node的路径是key的前缀
+        int pos = node->m_depth + radix_length(node->m_key);
+        if (pos == len)
+        {
+            if (!leaf)
+                return node;
+            //空序列最小，叶子在子节点表的首位，没有叶子时首个子节点也在该位置之后
+            if (!node->m_children.empty())
+                return node->m_children.begin()->second;
+            return skip_subtree(node);
+        }
+
+        K rest = radix_substr(key, pos, len - pos);
+        typename radix_tree_node<K, T>::iterator_child it = node->m_children.lower_bound(rest);
+        if (it != node->m_children.end() && it->first == rest)
+        {
+            node = it->second;
+            continue;
+        }
+        //边是rest的真前缀时排在rest之前
+        if (it != node->m_children.begin())
+        {
+            typename radix_tree_node<K, T>::iterator_child prev = it;
+            --prev;
+            if (!prev->second->m_is_leaf && radix_substr(rest, 0, radix_length(prev->first)) == prev->first)
+            {
+                node = prev->second;
+                continue;
+            }
+        }
+        if (it != node->m_children.end())
+            return it->second;
+        return skip_subtree(node);
+    }
+}
+
+template <typename K, typename T>
+K radix_tree<K, T>::node_path(const radix_tree_node<K, T> *node)
+{
+    K key = node->m_key;
+    for (node = node->m_parent; node != NULL; node = node->m_parent)
+        key = radix_join(node->m_key, key);
+    return key;
+}
 #endif //RADIX_TREE
\ No newline at end of file
@@ -4,11 +4,15 @@
 
 template <typename K, typename T> class radix_tree;
 template <typename K, typename T> class radix_tree_node;
+template <typename T> class radix_topic_matcher;
+template <typename T> class radix_string_scanner;
 
 template <typename K, typename T>
 class radix_tree_it : public std::iterator<std::forward_iterator_tag, std::pair<const K, T> >
 {
     friend class radix_tree<K, T>;
+    friend class radix_topic_matcher<T>;
+    friend class radix_string_scanner<T>;
 
 public:
     //构造函数
@@ -108,4 +112,22 @@ private:
         return get_first_leaf(it->second);
     }
 };
+
+/**
+ * @brief 不直接存储完整pair<const K, T>的容器所用的元素引用
+ * 迭代器解引用时由路径重建K，T仍引用容器内部存储，->运算符返回自身以支持it->first
+ */
+template <typename K, typename T>
+struct radix_pair_ref
+{
+    const K first;
+    T &second;
+
+    radix_pair_ref(const K &key, T &value) : first(key), second(value) {}
+
+    const radix_pair_ref *operator->() const
+    {
+        return this;
+    }
+};
 #endif //RADIX_TREE_IT
\ No newline at end of file
@@ -0,0 +1,767 @@
+#ifndef RADIX_TREE_JOURNAL
+#define RADIX_TREE_JOURNAL
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "radix_persistent_tree.h"
+#include "radix_serialize.h"
+
+/**
+ * @brief 带追加日志（journal）的持久化基数树
+ * 每次insert、operator[]赋值和erase在修改内存中的树之后，将记录追加到内存缓冲区，
+ * 由后台刷盘线程批量写入日志文件并fdatasync（组提交）。日志记录数达到阈值时，刷盘线程
+ * 获取树的O(1)快照并切换到新的日志文件，由后台检查点线程写出完整镜像，写线程不受影响。
+ * 重启时open()加载最新的检查点，再按顺序重放其后的日志，日志末尾不完整的记录被截断。
+ *
+ * 目录中的文件：
+ *  -checkpoint：检查点，记录其包含的日志代号之前的所有修改
+ *  -journal.<代号>：日志文件，代号不小于检查点代号的日志需要重放
+ *
+ * @note K和T需要支持radix_serialize/radix_deserialize
+ * @note 所有成员函数可以在多个线程中同时调用；单个读取用find，遍历请先通过snapshot()获取快照
+ */
+template <typename K, typename T>
+class radix_durable_tree
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef radix_persistent_tree<K, T> tree_type;
+    typedef std::size_t size_type;
+
+    /**
+     * @brief operator[]返回的代理，赋值时写入日志
+     */
+    class reference
+    {
+    public:
+        reference(radix_durable_tree &tree, const K &key) : m_tree(tree), m_key(key) {}
+
+        reference &operator=(const T &value)
+        {
+            m_tree.assign(m_key, value);
+            return *this;
+        }
+
+        operator T() const
+        {
+            T value = T();
+            m_tree.find(m_key, value);
+            return value;
+        }
+
+    private:
+        radix_durable_tree &m_tree;
+        K m_key;
+    };
+
+    //构造函数
+    /**
+     * @par sync_commit 为true时写操作等待其记录落盘后才返回，多个写线程共享一次fdatasync
+     * @par flush_interval_ms 不等待落盘时，刷盘线程批量写入的最长间隔
+     * @par checkpoint_records 两次检查点之间的日志记录数
+     */
+    radix_durable_tree(bool sync_commit = true, int flush_interval_ms = 2, size_type checkpoint_records = 100000)
+        : m_tree(), m_dir(), m_sync_commit(sync_commit), m_flush_interval(flush_interval_ms),
+          m_checkpoint_records(checkpoint_records), m_journal_fd(-1), m_gen(0), m_buffer(), m_lsn(0),
+          m_synced_lsn(0), m_records(0), m_waiters(0), m_open(false), m_stop(false), m_good(true),
+          m_checkpoint_gen(0), m_checkpoint_tree(), m_checkpoint_busy(false) {}
+
+    ~radix_durable_tree()
+    {
+        close();
+    }
+
+    //成员函数
+    /**
+     * @brief 打开目录dir，加载检查点并重放日志，启动后台线程
+     * @return 目录或文件无法读写时返回false
+     */
+    bool open(const std::string &dir);
+
+    /**
+     * @brief 将所有记录落盘后停止后台线程并关闭日志
+     */
+    void close();
+
+    bool is_open() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_open;
+    }
+
+    /**
+     * @brief 后台写入日志或检查点是否出现过错误，出错后所有写操作都被拒绝
+     */
+    bool good() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_good;
+    }
+
+    size_type size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_tree.size();
+    }
+
+    /**
+     * @brief 获取当前内容的只读快照，O(1)
+     */
+    tree_type snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_tree.snapshot();
+    }
+
+    /**
+     * @brief 在当前内容中查找key，不获取快照，不影响之后写操作的路径复制
+     * @return 不存在时返回false，value不变
+     */
+    bool find(const K &key, T &value) const;
+
+    /**
+     * @brief 插入元素并写入日志
+     * @return 已存在、未打开或日志出错时返回false；同步提交时记录未能落盘也返回false，
+     * 此时内存中的修改已生效，但不保证重启后仍然存在
+     */
+    bool insert(const value_type &val);
+
+    reference operator[](const K &key)
+    {
+        return reference(*this, key);
+    }
+
+    /**
+     * @brief 将key对应的值设为value，不存在时插入，并写入日志
+     * @return 未打开或写入日志失败时返回false，与insert相同
+     */
+    bool assign(const K &key, const T &value);
+
+    /**
+     * @brief 删除序列并写入日志，如果树中不存在此序列返回false
+     * @return 未打开或写入日志失败时也返回false，与insert相同
+     */
+    bool erase(const K &key);
+
+    /**
+     * @brief 等待此前所有修改落盘
+     * @return 有记录未能落盘时返回false
+     */
+    bool sync();
+
+    /**
+     * @brief 立即请求一次后台检查点
+     */
+    void checkpoint();
+
+private:
+    enum
+    {
+        RECORD_INSERT = 1,
+        RECORD_ASSIGN = 2,
+        RECORD_ERASE = 3
+    };
+
+    tree_type m_tree;
+    std::string m_dir;
+    bool m_sync_commit;
+    int m_flush_interval;
+    size_type m_checkpoint_records;
+
+    /**
+     * @note 以下成员由m_mutex保护，日志文件只由刷盘线程写入
+     */
+    mutable std::mutex m_mutex;
+    std::condition_variable m_flush_cond;
+    std::condition_variable m_synced_cond;
+    std::condition_variable m_checkpoint_cond;
+    int m_journal_fd;
+    unsigned long m_gen;
+    std::string m_buffer;
+    unsigned long m_lsn;
+    unsigned long m_synced_lsn;
+    size_type m_records;
+    int m_waiters;
+    bool m_open;
+    bool m_stop;
+    bool m_good;
+
+    /**
+     * @note 等待检查点线程写出的快照及其代号
+     */
+    unsigned long m_checkpoint_gen;
+    tree_type m_checkpoint_tree;
+    bool m_checkpoint_busy;
+
+    std::thread m_flusher;
+    std::thread m_checkpointer;
+
+    /**
+     * @brief 将一条记录追加到缓冲区，调用时持有锁
+     * @return 记录的序号
+     */
+    unsigned long append(int op, const K &key, const T *value);
+
+    /**
+     * @brief 同步提交时等待序号为lsn的记录落盘
+     * @return 记录无法落盘时返回false
+     */
+    bool wait_synced(std::unique_lock<std::mutex> &lock, unsigned long lsn);
+
+    void flush_loop();
+
+    void checkpoint_loop();
+
+    /**
+     * @brief 交换缓冲区并切换到新的日志文件，调用时持有锁
+     */
+    void rotate(std::unique_lock<std::mutex> &lock);
+
+    /**
+     * @brief 将快照写入检查点文件，先写临时文件再重命名
+     */
+    bool write_checkpoint(const tree_type &tree, unsigned long gen) const;
+
+    /**
+     * @brief 加载检查点并重放其后的日志，设置当前日志代号
+     */
+    bool recover();
+
+    /**
+     * @brief 加载检查点，返回其代号，不存在时为0
+     */
+    bool load_checkpoint(unsigned long &gen);
+
+    /**
+     * @brief 重放日志文件，截断末尾不完整的记录
+     */
+    bool replay(unsigned long gen);
+
+    std::string journal_path(unsigned long gen) const;
+
+    /**
+     * @brief 使目录中新建或重命名的文件落盘
+     */
+    void sync_dir() const;
+
+    static bool write_all(int fd, const char *data, size_type len);
+
+    static bool read_file(const std::string &path, std::string &data);
+
+    static unsigned int checksum(const char *data, size_type len);
+
+    radix_durable_tree(const radix_durable_tree &);
+    radix_durable_tree &operator=(const radix_durable_tree &);
+};
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::open(const std::string &dir)
+{
+    if (is_open())
+        return false;
+    m_dir = dir;
+    m_tree.clear();
+
+    if (recover())
+        m_journal_fd = ::open(journal_path(m_gen).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (m_journal_fd < 0)
+    {
+        //不保留加载了一部分的内容
+        m_tree.clear();
+        m_dir.clear();
+        m_gen = 0;
+        return false;
+    }
+    sync_dir();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.clear();
+        m_lsn = m_synced_lsn = 0;
+        m_records = 0;
+        m_open = true;
+        m_stop = false;
+        m_good = true;
+    }
+    m_flusher = std::thread(&radix_durable_tree::flush_loop, this);
+    m_checkpointer = std::thread(&radix_durable_tree::checkpoint_loop, this);
+    return true;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::recover()
+{
+    unsigned long gen;
+    if (!load_checkpoint(gen))
+        return false;
+
+    //代号不小于检查点的日志按顺序重放
+    std::vector<unsigned long> gens;
+    DIR *d = opendir(m_dir.c_str());
+    if (d == NULL)
+        return false;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL)
+    {
+        unsigned long g;
+        char tail;
+        if (sscanf(entry->d_name, "journal.%lu%c", &g, &tail) == 1 && g >= gen)
+            gens.push_back(g);
+    }
+    closedir(d);
+    std::sort(gens.begin(), gens.end());
+
+    for (size_type i = 0; i < gens.size(); i++)
+        if (!replay(gens[i]))
+            return false;
+
+    m_gen = gens.empty() ? (gen > 0 ? gen : 1) : gens.back();
+    return true;
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_open)
+            return;
+        //之后的写操作被拒绝，已追加的记录由刷盘线程写完后再退出
+        m_open = false;
+        m_stop = true;
+    }
+    m_flush_cond.notify_all();
+    m_checkpoint_cond.notify_all();
+    m_flusher.join();
+    m_checkpointer.join();
+
+    ::close(m_journal_fd);
+    m_journal_fd = -1;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::find(const K &key, T &value) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    typename tree_type::iterator it = m_tree.find(key);
+    if (it == m_tree.end())
+        return false;
+    value = it->second;
+    return true;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::insert(const value_type &val)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_open || !m_good || !m_tree.insert(val))
+        return false;
+    unsigned long lsn = append(RECORD_INSERT, val.first, &val.second);
+    return wait_synced(lock, lsn);
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::assign(const K &key, const T &value)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_open || !m_good)
+        return false;
+    m_tree[key] = value;
+    unsigned long lsn = append(RECORD_ASSIGN, key, &value);
+    return wait_synced(lock, lsn);
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::erase(const K &key)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_open || !m_good || !m_tree.erase(key))
+        return false;
+    unsigned long lsn = append(RECORD_ERASE, key, NULL);
+    return wait_synced(lock, lsn);
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::sync()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiters++;
+    m_flush_cond.notify_one();
+    unsigned long lsn = m_lsn;
+    while (m_synced_lsn < lsn && m_good)
+        m_synced_cond.wait(lock);
+    m_waiters--;
+    return m_synced_lsn >= lsn;
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::checkpoint()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records = m_checkpoint_records;
+    m_flush_cond.notify_one();
+}
+
+template <typename K, typename T>
+unsigned long radix_durable_tree<K, T>::append(int op, const K &key, const T *value)
+{
+    //记录格式：负载长度、负载校验和、负载（操作类型、K、T）
+    size_type head = m_buffer.size();
+    unsigned int len = 0, sum = 0;
+    m_buffer.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    m_buffer.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+    m_buffer.push_back((char)op);
+    radix_serialize(m_buffer, key);
+    if (value != NULL)
+        radix_serialize(m_buffer, *value);
+
+    size_type payload = head + sizeof(len) + sizeof(sum);
+    len = m_buffer.size() - payload;
+    sum = checksum(m_buffer.data() + payload, len);
+    memcpy(&m_buffer[head], &len, sizeof(len));
+    memcpy(&m_buffer[head + sizeof(len)], &sum, sizeof(sum));
+
+    //缓冲区由空变为非空或需要检查点时唤醒空闲的刷盘线程
+    m_records++;
+    if (head == 0 || m_records >= m_checkpoint_records)
+        m_flush_cond.notify_one();
+    return ++m_lsn;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::wait_synced(std::unique_lock<std::mutex> &lock, unsigned long lsn)
+{
+    if (!m_sync_commit)
+        return m_good;
+
+    //等待期间释放锁，其他写线程的记录进入同一批次；close()时刷盘线程会写完已追加的记录
+    m_waiters++;
+    m_flush_cond.notify_one();
+    while (m_synced_lsn < lsn && m_good)
+        m_synced_cond.wait(lock);
+    m_waiters--;
+    return m_synced_lsn >= lsn;
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::flush_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        //缓冲区为空时等待唤醒；没有等待落盘的写线程时，最多等待一个间隔以积累更多记录
+        bool rotating = m_records >= m_checkpoint_records && !m_checkpoint_busy && m_good;
+        if (!rotating && !m_stop)
+        {
+            if (m_buffer.empty())
+                m_flush_cond.wait(lock);
+            else if (m_waiters == 0)
+                m_flush_cond.wait_for(lock, std::chrono::milliseconds(m_flush_interval));
+        }
+
+        //检查点线程空闲时切换日志，否则推迟到下一轮
+        if (m_records >= m_checkpoint_records && !m_checkpoint_busy && m_good && !m_stop)
+        {
+            rotate(lock);
+            continue;
+        }
+
+        //出错后日志中已有缺口，之后的记录不再写入，否则重放时会跳过丢失的修改
+        if (!m_good)
+            m_buffer.clear();
+
+        if (!m_buffer.empty())
+        {
+            std::string data;
+            data.swap(m_buffer);
+            unsigned long lsn = m_lsn;
+            int fd = m_journal_fd;
+
+            lock.unlock();
+            bool ok = write_all(fd, data.data(), data.size()) && fdatasync(fd) == 0;
+            lock.lock();
+
+            //失败时不推进已落盘的序号，等待的写线程因m_good返回失败
+            if (ok)
+                m_synced_lsn = lsn;
+            else
+                m_good = false;
+            m_synced_cond.notify_all();
+        }
+        else if (m_stop)
+            return;
+    }
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::rotate(std::unique_lock<std::mutex> &lock)
+{
+    //缓冲区中的记录属于旧日志，快照恰好包含到这些记录为止
+    std::string data;
+    data.swap(m_buffer);
+    unsigned long lsn = m_lsn;
+    int old_fd = m_journal_fd;
+    unsigned long gen = m_gen + 1;
+    int fd = ::open(journal_path(gen).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        m_buffer.swap(data);
+        m_good = false;
+        m_records = 0;
+        m_synced_cond.notify_all();
+        return;
+    }
+
+    m_checkpoint_tree = m_tree.snapshot();
+    m_checkpoint_gen = gen;
+    m_checkpoint_busy = true;
+    m_journal_fd = fd;
+    m_gen = gen;
+    m_records = 0;
+
+    //新日志必须先于依赖它的检查点落盘，否则崩溃后检查点之后的记录无处重放
+    lock.unlock();
+    sync_dir();
+    bool ok = write_all(old_fd, data.data(), data.size()) && fdatasync(old_fd) == 0;
+    ::close(old_fd);
+    lock.lock();
+
+    if (ok)
+        m_synced_lsn = lsn;
+    else
+        m_good = false;
+    m_synced_cond.notify_all();
+    m_checkpoint_cond.notify_one();
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::checkpoint_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        while (!m_checkpoint_busy && !m_stop)
+            m_checkpoint_cond.wait(lock);
+        if (!m_checkpoint_busy)
+            return;
+
+        tree_type tree = m_checkpoint_tree;
+        unsigned long gen = m_checkpoint_gen;
+        m_checkpoint_tree.clear();
+
+        lock.unlock();
+        bool ok = write_checkpoint(tree, gen);
+        //检查点生效后，之前的日志不再需要
+        if (ok)
+            for (unsigned long g = gen; g > 0 && unlink(journal_path(g - 1).c_str()) == 0; g--)
+                ;
+        tree.clear();
+        lock.lock();
+
+        if (!ok)
+            m_good = false;
+        m_checkpoint_busy = false;
+        //检查点期间推迟的切换
+        if (m_records >= m_checkpoint_records)
+            m_flush_cond.notify_one();
+    }
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::write_checkpoint(const tree_type &tree, unsigned long gen) const
+{
+    std::string path = m_dir + "/checkpoint";
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    //格式：代号、元素个数、元素，最后是元素部分的校验和
+    std::string data;
+    radix_serialize(data, gen);
+    radix_serialize(data, (unsigned long)tree.size());
+    bool ok = true;
+    unsigned int sum = 0;
+    typename tree_type::iterator it;
+    for (it = tree.begin(); it != tree.end() && ok; ++it)
+    {
+        size_type begin = data.size();
+        radix_serialize(data, it->first);
+        radix_serialize(data, it->second);
+        sum = sum * 31 + checksum(data.data() + begin, data.size() - begin);
+        if (data.size() >= (1 << 20))
+        {
+            ok = write_all(fd, data.data(), data.size());
+            data.clear();
+        }
+    }
+    radix_serialize(data, sum);
+    ok = ok && write_all(fd, data.data(), data.size()) && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        return false;
+
+    //保证重命名落盘
+    sync_dir();
+    return true;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::load_checkpoint(unsigned long &gen)
+{
+    gen = 0;
+    std::string data;
+    if (!read_file(m_dir + "/checkpoint", data))
+        return access((m_dir + "/checkpoint").c_str(), F_OK) != 0;
+
+    const char *p = data.data();
+    const char *end = p + data.size();
+    unsigned long count;
+    if (!radix_deserialize(p, end, gen) || !radix_deserialize(p, end, count))
+        return false;
+
+    unsigned int sum = 0;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        const char *begin = p;
+        std::pair<K, T> val;
+        if (!radix_deserialize(p, end, val.first) || !radix_deserialize(p, end, val.second))
+            return false;
+        sum = sum * 31 + checksum(begin, p - begin);
+        m_tree.insert(val);
+    }
+
+    unsigned int expected;
+    return radix_deserialize(p, end, expected) && expected == sum;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::replay(unsigned long gen)
+{
+    std::string path = journal_path(gen);
+    std::string data;
+    if (!read_file(path, data))
+        return false;
+
+    const char *p = data.data();
+    const char *end = p + data.size();
+    while (true)
+    {
+        const char *record = p;
+        unsigned int len, sum;
+        if (!radix_deserialize(p, end, len) || !radix_deserialize(p, end, sum) ||
+            (unsigned long)(end - p) < len || checksum(p, len) != sum || len == 0)
+        {
+            //崩溃时写了一半的记录，截断后继续追加
+            if (record != end && truncate(path.c_str(), record - data.data()) != 0)
+                return false;
+            return true;
+        }
+
+        const char *payload_end = p + len;
+        int op = *p++;
+        std::pair<K, T> val;
+        if (!radix_deserialize(p, payload_end, val.first))
+            return false;
+        if (op != RECORD_ERASE && !radix_deserialize(p, payload_end, val.second))
+            return false;
+
+        if (op == RECORD_INSERT)
+            m_tree.insert(val);
+        else if (op == RECORD_ASSIGN)
+            m_tree[val.first] = val.second;
+        else if (op == RECORD_ERASE)
+            m_tree.erase(val.first);
+        p = payload_end;
+    }
+}
+
+template <typename K, typename T>
+std::string radix_durable_tree<K, T>::journal_path(unsigned long gen) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/journal.%lu", gen);
+    return m_dir + name;
+}
+
+template <typename K, typename T>
+void radix_durable_tree<K, T>::sync_dir() const
+{
+    int dir_fd = ::open(m_dir.c_str(), O_RDONLY);
+    if (dir_fd >= 0)
+    {
+        fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::write_all(int fd, const char *data, size_type len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+template <typename K, typename T>
+bool radix_durable_tree<K, T>::read_file(const std::string &path, std::string &data)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char buf[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) != 0)
+    {
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ::close(fd);
+            return false;
+        }
+        data.append(buf, n);
+    }
+    ::close(fd);
+    return true;
+}
+
+template <typename K, typename T>
+unsigned int radix_durable_tree<K, T>::checksum(const char *data, size_type len)
+{
+    //FNV-1a
+    unsigned int hash = 2166136261u;
+    for (size_type i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+#endif //RADIX_TREE_JOURNAL
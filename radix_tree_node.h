@@ -7,6 +7,8 @@ class radix_tree_node
 {
     friend class radix_tree<K, T>;
     friend class radix_tree_it<K, T>;
+    friend class radix_topic_matcher<T>;
+    friend class radix_string_scanner<T>;
 
     typedef std::pair<const K, T> value_type;
     /**
@@ -41,6 +43,12 @@ private:
     int m_depth;
     bool m_is_leaf;
 
+    /**
+     * @note 节点与值所在的radix_tree内存块下标，-1表示单独分配
+     */
+    int m_pool;
+    int m_value_pool;
+
     //构造函数
     /**
      * @note 初始化列表中m_key()的含义
@@ -48,8 +56,8 @@ private:
      *  -如果m_key是整形，其执行时会被初始化为0。
      *  -如果m_key是class类型，则该类必须有默认构造函数，否则无法编译。
      */
-    radix_tree_node() : m_key(), m_value(), m_children(), m_parent(nullptr), m_depth(0), m_is_leaf(false) {}
-    radix_tree_node(const value_type &val) : m_key(), m_value(), m_children(), m_parent(nullptr), m_depth(0), m_is_leaf(false)
+    radix_tree_node() : m_key(), m_value(), m_children(), m_parent(nullptr), m_depth(0), m_is_leaf(false), m_pool(-1), m_value_pool(-1) {}
+    radix_tree_node(const value_type &val) : m_key(), m_value(), m_children(), m_parent(nullptr), m_depth(0), m_is_leaf(false), m_pool(-1), m_value_pool(-1)
     {
         m_value = new value_type(val);
     }
@@ -0,0 +1,200 @@
+#ifndef RADIX_VALUE_STORE
+#define RADIX_VALUE_STORE
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cassert>
+
+/**
+ * @brief radix_compact_tree的默认值存储：每个元素在连续数组中独占一个值
+ * @note 删除的下标进入空闲链表复用
+ */
+template <typename T>
+class radix_value_store
+{
+public:
+    //元素解引用得到的值类型，可以原地修改
+    typedef T stored_type;
+    typedef std::size_t size_type;
+    typedef unsigned int index_type;
+
+    //构造函数
+    radix_value_store() : m_values(), m_free() {}
+
+    //成员函数
+    /**
+     * @brief 保存value，返回其下标
+     */
+    index_type add(const T &value);
+
+    /**
+     * @brief 释放add返回的下标
+     */
+    void remove(index_type index);
+
+    /**
+     * @brief 将index处的值改为value，返回修改后的下标
+     */
+    index_type assign(index_type index, const T &value)
+    {
+        m_values[index] = value;
+        return index;
+    }
+
+    stored_type &get(index_type index)
+    {
+        return m_values[index];
+    }
+
+    /**
+     * @brief 实际保存的值的个数
+     */
+    size_type size() const
+    {
+        return m_values.size() - m_free.size();
+    }
+
+    void clear()
+    {
+        m_values.clear();
+        m_free.clear();
+    }
+
+private:
+    std::vector<T> m_values;
+    std::vector<index_type> m_free;
+};
+
+/**
+ * @brief 值驻留存储：相等的值只保存一份，元素只保存其下标
+ * 适用于大量元素映射到少数不同值的场景，例如路由表的下一跳和标签表。
+ * 每个值带有引用计数，最后一个引用释放后其下标才被复用。
+ * @note 共享的值不能原地修改，解引用得到常量引用，修改需通过assign
+ * @par Hash 值的哈希函数
+ * @par Equal 值的相等比较
+ */
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T> >
+class radix_interned_store
+{
+public:
+    typedef const T stored_type;
+    typedef std::size_t size_type;
+    typedef unsigned int index_type;
+
+    //构造函数
+    explicit radix_interned_store(const Hash &hash = Hash(), const Equal &equal = Equal())
+        : m_values(), m_refs(), m_free(), m_index(16, hash, equal) {}
+
+    //成员函数
+    index_type add(const T &value);
+
+    void remove(index_type index);
+
+    index_type assign(index_type index, const T &value)
+    {
+        //先增加新值的引用，新旧值相等时不会被释放
+        index_type result = add(value);
+        remove(index);
+        return result;
+    }
+
+    stored_type &get(index_type index)
+    {
+        return m_values[index];
+    }
+
+    /**
+     * @brief 不同值的个数
+     */
+    size_type size() const
+    {
+        return m_index.size();
+    }
+
+    /**
+     * @brief index处的值被引用的次数
+     */
+    size_type references(index_type index) const
+    {
+        return m_refs[index];
+    }
+
+    void clear()
+    {
+        m_values.clear();
+        m_refs.clear();
+        m_free.clear();
+        m_index.clear();
+    }
+
+private:
+    typedef std::unordered_map<T, index_type, Hash, Equal> index_map;
+
+    std::vector<T> m_values;
+    std::vector<size_type> m_refs;
+    std::vector<index_type> m_free;
+    index_map m_index;
+};
+
+template <typename T>
+typename radix_value_store<T>::index_type radix_value_store<T>::add(const T &value)
+{
+    if (m_free.empty())
+    {
+        m_values.push_back(value);
+        return m_values.size() - 1;
+    }
+    index_type index = m_free.back();
+    m_free.pop_back();
+    m_values[index] = value;
+    return index;
+}
+
+template <typename T>
+void radix_value_store<T>::remove(index_type index)
+{
+    m_values[index] = T();
+    m_free.push_back(index);
+}
+
+template <typename T, typename Hash, typename Equal>
+typename radix_interned_store<T, Hash, Equal>::index_type radix_interned_store<T, Hash, Equal>::add(const T &value)
+{
+    typename index_map::iterator it = m_index.find(value);
+    if (it != m_index.end())
+    {
+        m_refs[it->second]++;
+        return it->second;
+    }
+
+    index_type index;
+    if (m_free.empty())
+    {
+        index = m_values.size();
+        m_values.push_back(value);
+        m_refs.push_back(0);
+    }
+    else
+    {
+        index = m_free.back();
+        m_free.pop_back();
+        m_values[index] = value;
+    }
+    m_refs[index] = 1;
+    m_index.insert(std::make_pair(value, index));
+    return index;
+}
+
+template <typename T, typename Hash, typename Equal>
+void radix_interned_store<T, Hash, Equal>::remove(index_type index)
+{
+    assert(m_refs[index] > 0);
+    if (--m_refs[index] != 0)
+        return;
+
+    m_index.erase(m_values[index]);
+    m_values[index] = T();
+    m_free.push_back(index);
+}
+#endif //RADIX_VALUE_STORE
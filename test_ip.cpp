@@ -2,6 +2,9 @@
 #include <arpa/inet.h>
 
 #include "radix_tree.h"
+#include "radix_lookup_cache.h"
+#include "radix_route_aggregator.h"
+#include "radix_compact_tree.h"
 
 using namespace std;
 
@@ -83,12 +86,13 @@ route_entry radix_substr<route_entry>(const route_entry &entry, int begin, int n
     route_entry r;
     in_addr_t mask_substr;
 
+    if (begin + num > entry.len_prefix) //数量超出序列长度，与string::substr相同只截取到末尾
+        num = entry.len_prefix > begin ? entry.len_prefix - begin : 0;
+
     if (num == 0) //空序列
         r.addr = 0;
     else
     {
-        if (begin + num > 32) //数量超出上限
-            num = 32 - begin;
         //计算掩码位数
         //再移动掩码到begin处,偏移量为begin到结尾的序列长度-掩码长度
         mask_substr = ((1 << num) - 1) << (32 - begin - num);
@@ -114,6 +118,48 @@ int radix_length<route_entry>(const route_entry &entry)
     return entry.len_prefix;
 }
 
+/**
+ * @brief route_entry的哈希函数，供查找缓存使用
+ */
+struct route_hash
+{
+    std::size_t operator()(const route_entry &entry) const
+    {
+        return (entry.addr * 2654435761u) ^ entry.len_prefix;
+    }
+};
+
+template <>
+route_entry radix_bit<route_entry>(int bit)
+{
+    route_entry r;
+    r.addr = bit ? 0x80000000 : 0;
+    r.len_prefix = 1;
+    return r;
+}
+
+/**
+ * @brief in_addr未重载==，路由聚合时比较下一跳
+ */
+struct in_addr_equal
+{
+    bool operator()(const in_addr &a, const in_addr &b) const
+    {
+        return a.s_addr == b.s_addr;
+    }
+};
+
+/**
+ * @brief in_addr的哈希函数，供下一跳驻留使用
+ */
+struct in_addr_hash
+{
+    std::size_t operator()(const in_addr &a) const
+    {
+        return a.s_addr * 2654435761u;
+    }
+};
+
 radix_tree<route_entry, in_addr> rttable;
 
 /**
@@ -147,6 +193,84 @@ void find(const char *dst)
         cout << dst << "->" << inet_ntoa(it->second) << endl;
 }
 
+/**
+ * 由短到长输出所有覆盖dst的路由项
+ */
+void find_all(const char *dst)
+{
+    route_entry entry(dst, 32);
+    vector<radix_tree<route_entry, in_addr>::iterator> vec;
+    rttable.all_prefixes_of(entry, vec);
+    cout << dst << ":";
+    for (size_t i = 0; i < vec.size(); i++)
+        cout << " /" << vec[i]->first.len_prefix << "->" << inet_ntoa(vec[i]->second);
+    cout << endl;
+}
+
+/**
+ * 重复查找少量目的地址，中途修改路由表使缓存失效
+ */
+void cached_find()
+{
+    radix_lookup_cache<route_entry, in_addr, route_hash> cache(rttable, 64, 2);
+    const char *dsts[] = {"10.1.1.1", "172.16.1.3", "192.168.2.220"};
+    for (int i = 0; i < 300; i++)
+    {
+        if (i == 150)
+            insert("10.1.0.0", 16, "192.168.0.11");
+        cache.longest_match(route_entry(dsts[i % 3], 32));
+    }
+    radix_tree<route_entry, in_addr>::iterator it = cache.longest_match(route_entry("10.1.1.1", 32));
+    cout << "cached 10.1.1.1->" << inet_ntoa(it->second) << " hits:" << cache.hits() << " misses:" << cache.misses() << endl;
+}
+
+void print_fib(radix_tree<route_entry, in_addr> &fib)
+{
+    radix_tree<route_entry, in_addr>::iterator it;
+    for (it = fib.begin(); it != fib.end(); ++it)
+    {
+        in_addr net;
+        net.s_addr = htonl(it->first.addr);
+        cout << inet_ntoa(net) << "/" << it->first.len_prefix << "->";
+        cout << inet_ntoa(it->second) << endl;
+    }
+}
+
+/**
+ * 聚合路由表，再增量插入与删除
+ */
+void aggregate()
+{
+    insert("172.20.0.0", 16, "192.168.0.1"); //与默认路由相同
+    radix_route_aggregator<route_entry, in_addr, in_addr_equal> aggregator(rttable);
+    cout << "aggregate " << aggregator.size() << "->" << aggregator.fib().size() << endl;
+    print_fib(aggregator.fib());
+
+    in_addr hop;
+    inet_aton("192.168.0.3", &hop);
+    aggregator.insert(route_entry("172.17.0.0", 16), hop);
+    aggregator.erase(route_entry("172.20.0.0", 16));
+    cout << "after update " << aggregator.size() << "->" << aggregator.fib().size() << endl;
+    print_fib(aggregator.fib());
+}
+
+/**
+ * 下一跳驻留：多条路由共享同一个下一跳时只保存一份
+ */
+void interned_find()
+{
+    typedef radix_compact_tree<route_entry, in_addr, radix_interned_store<in_addr, in_addr_hash, in_addr_equal> > table_type;
+    table_type table(rttable);
+    cout << "interned " << table.size() << " routes, " << table.store().size() << " next hops" << endl;
+
+    in_addr hop;
+    inet_aton("192.168.0.1", &hop);
+    table.assign(route_entry("192.168.1.0", 24), hop);
+    table.assign(route_entry("192.168.2.0", 24), hop);
+    table_type::iterator it = table.longest_match(route_entry("192.168.2.220", 32));
+    cout << "192.168.2.220->" << inet_ntoa(it->second) << " next hops:" << table.store().size() << endl;
+}
+
 int main(int argc, char const *argv[])
 {
     insert("0.0.0.0", 0, "192.168.0.1"); // default route
@@ -172,5 +296,12 @@ int main(int argc, char const *argv[])
     find("192.168.3.80");
     find("192.168.4.100");
     find("172.20.0.1");
+
+    find_all("172.16.1.3");
+    find_all("172.17.0.5");
+
+    cached_find();
+    aggregate();
+    interned_find();
     return 0;
 }
\ No newline at end of file
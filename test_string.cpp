@@ -1,7 +1,19 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
 #include "radix_tree.h"
+#include "radix_burst_tree.h"
+#include "radix_persistent_tree.h"
+#include "radix_topic_matcher.h"
+#include "radix_compact_tree.h"
+#include "radix_string_scanner.h"
+#include "radix_tree_journal.h"
+#include "radix_paged_tree.h"
 
 using namespace std;
 
@@ -66,6 +78,317 @@ void greedy_match(string key)
     print_vec();
 }
 
+void set_operation()
+{
+    radix_tree<string, int> other;
+    other["binary"] = 5;
+    other["bind"] = 60;
+    other["brave"] = 11;
+
+    vector<radix_tree<string, int>::iterator> added, removed;
+    vector<pair<radix_tree<string, int>::iterator, radix_tree<string, int>::iterator> > changed;
+    tree.diff(other, added, removed, changed);
+    cout << "diff" << endl;
+    for (it_vec = added.begin(); it_vec != added.end(); ++it_vec)
+        cout << "+" << (*it_vec)->first << endl;
+    for (it_vec = removed.begin(); it_vec != removed.end(); ++it_vec)
+        cout << "-" << (*it_vec)->first << endl;
+    for (size_t i = 0; i < changed.size(); i++)
+        cout << "~" << changed[i].first->first << ":" << changed[i].first->second << "->" << changed[i].second->second << endl;
+
+    radix_tree<string, int> merged;
+    merged.merge(tree);
+    merged.merge(other);
+    cout << "merge:" << merged.size() << endl;
+
+    merged.intersect(other);
+    cout << "intersect:" << merged.size() << endl;
+
+    merged.difference(tree);
+    cout << "difference:" << merged.size() << endl;
+}
+
+/**
+ * 增量整理，两次调用之间插入和删除元素，整理仍能完成且内容不变
+ */
+void compact_steps()
+{
+    radix_tree<string, int> steps(tree);
+    map<string, int> expected;
+    for (it_radix = tree.begin(); it_radix != tree.end(); ++it_radix)
+        expected.insert(*it_radix);
+
+    int calls = 0;
+    for (; !steps.compact_step(3) && calls < 1000; calls++)
+    {
+        string key = tree.begin()->first + to_string(calls);
+        steps[key] = calls;
+        expected[key] = calls;
+        if (calls % 2)
+        {
+            steps.erase(expected.rbegin()->first);
+            expected.erase(expected.rbegin()->first);
+        }
+    }
+
+    bool same = steps.size() == expected.size();
+    map<string, int>::iterator it_map = expected.begin();
+    for (it_radix = steps.begin(); same && it_radix != steps.end(); ++it_radix, ++it_map)
+        same = it_radix->first == it_map->first && it_radix->second == it_map->second;
+    cout << "compact_step calls:" << calls << " " << (same ? "same" : "different") << endl;
+}
+
+void burst_tree()
+{
+    radix_burst_tree<string, int> burst(4);
+    for (it_radix = tree.begin(); it_radix != tree.end(); ++it_radix)
+        burst[it_radix->first] = it_radix->second;
+
+    vector<radix_burst_tree<string, int>::iterator> vec_burst;
+    burst.prefix_match("b", vec_burst);
+    cout << "burst prefix_match(b)" << endl;
+    for (size_t i = 0; i < vec_burst.size(); i++)
+        cout << vec_burst[i]->first << ":" << vec_burst[i]->second << endl;
+
+    radix_burst_tree<string, int>::iterator it = burst.longest_match("binder");
+    cout << "burst longest_match(binder)" << endl;
+    cout << (it == burst.end() ? "failed" : it->first) << endl;
+}
+
+void compact_tree()
+{
+    radix_compact_tree<string, int> compact(tree);
+    compact.erase("bind");
+    compact["bite"] = 13;
+
+    vector<radix_compact_tree<string, int>::iterator> vec_compact;
+    compact.prefix_match("bi", vec_compact);
+    cout << "compact prefix_match(bi)" << endl;
+    for (size_t i = 0; i < vec_compact.size(); i++)
+        cout << vec_compact[i]->first << ":" << vec_compact[i]->second << endl;
+    cout << "compact size:" << compact.size() << " nodes:" << compact.node_count() << endl;
+}
+
+void scan_text(string text)
+{
+    radix_string_scanner<int> scanner(tree);
+    vector<radix_string_scanner<int>::match_type> matches;
+    scanner.scan(text, matches);
+    cout << "scan(" << text << ")" << endl;
+    for (size_t i = 0; i < matches.size(); i++)
+        cout << matches[i].first - matches[i].second->first.size() << ":" << matches[i].second->first << endl;
+
+    //按小块流式输入，跨越块边界的匹配与一次扫描的结果相同
+    for (size_t chunk = 1; chunk <= 4; chunk++)
+    {
+        vector<radix_string_scanner<int>::match_type> streamed, part;
+        scanner.reset();
+        for (size_t pos = 0; pos < text.size(); pos += chunk)
+        {
+            scanner.feed(text.substr(pos, chunk), part);
+            streamed.insert(streamed.end(), part.begin(), part.end());
+        }
+        cout << "feed chunk " << chunk << ":" << (streamed == matches ? "same" : "different") << endl;
+    }
+}
+
+void persistent_tree()
+{
+    radix_persistent_tree<string, int> routes;
+    for (it_radix = tree.begin(); it_radix != tree.end(); ++it_radix)
+        routes.insert(*it_radix);
+
+    radix_persistent_tree<string, int> old = routes.snapshot();
+    routes.erase("apache");
+    routes["binder"] = 12;
+    routes["bind"] = 66;
+
+    vector<radix_persistent_tree<string, int>::iterator> added, removed;
+    vector<pair<radix_persistent_tree<string, int>::iterator, radix_persistent_tree<string, int>::iterator> > changed;
+    old.diff(routes, added, removed, changed);
+    cout << "snapshot diff" << endl;
+    for (size_t i = 0; i < added.size(); i++)
+        cout << "+" << added[i]->first << endl;
+    for (size_t i = 0; i < removed.size(); i++)
+        cout << "-" << removed[i]->first << endl;
+    for (size_t i = 0; i < changed.size(); i++)
+        cout << "~" << changed[i].first->first << ":" << changed[i].first->second << "->" << changed[i].second->second << endl;
+
+    routes = old;
+    cout << "rollback:" << routes.size() << " " << (routes.find("apache") != routes.end()) << endl;
+}
+
+/**
+ * 对目录中每个文件执行func(路径)
+ */
+template <typename F>
+void for_each_file(const string &dir, const string &prefix, F func)
+{
+    DIR *d = opendir(dir.c_str());
+    struct dirent *entry;
+    while (d != NULL && (entry = readdir(d)) != NULL)
+        if (string(entry->d_name).compare(0, prefix.size(), prefix) == 0)
+            func(dir + "/" + entry->d_name);
+    if (d != NULL)
+        closedir(d);
+}
+
+bool same_content(radix_durable_tree<string, int> &durable, const map<string, int> &expected)
+{
+    radix_persistent_tree<string, int> snapshot = durable.snapshot();
+    map<string, int>::const_iterator it_map = expected.begin();
+    radix_persistent_tree<string, int>::iterator it;
+    for (it = snapshot.begin(); it != snapshot.end(); ++it, ++it_map)
+        if (it_map == expected.end() || it->first != it_map->first || it->second != it_map->second)
+            return false;
+    return it_map == expected.end();
+}
+
+/**
+ * 写入后关闭再打开，检查点生成，日志末尾写了一半的记录被截断
+ */
+void durable_tree()
+{
+    char name[] = "/tmp/radix_durable_XXXXXX";
+    if (mkdtemp(name) == NULL)
+        return;
+    string dir = name;
+    map<string, int> expected;
+
+    {
+        //每4条记录切换一次日志并生成检查点
+        radix_durable_tree<string, int> durable(true, 2, 4);
+        durable.open(dir);
+        for (it_radix = tree.begin(); it_radix != tree.end(); ++it_radix)
+        {
+            durable.insert(*it_radix);
+            expected.insert(*it_radix);
+        }
+        durable.erase("apache");
+        expected.erase("apache");
+        durable["bind"] = 66;
+        expected["bind"] = 66;
+        cout << "durable bind:" << durable["bind"] << endl;
+    }
+
+    radix_durable_tree<string, int> durable(true, 2, 4);
+    cout << "durable reopen:" << durable.open(dir) << " " << same_content(durable, expected) << endl;
+    cout << "durable checkpoint:" << (access((dir + "/checkpoint").c_str(), F_OK) == 0) << endl;
+    durable["binder"] = 12;
+    expected["binder"] = 12;
+    durable.close();
+
+    //模拟崩溃时只写了一半的记录：长度字段声明的负载超出文件末尾
+    for_each_file(dir, "journal.", [](const string &path) {
+        FILE *file = fopen(path.c_str(), "ab");
+        unsigned char torn[9] = {100};
+        fwrite(torn, 1, sizeof(torn), file);
+        fclose(file);
+    });
+    cout << "durable torn tail:" << durable.open(dir) << " " << same_content(durable, expected) << endl;
+    durable.insert(make_pair(string("brave"), 11));
+    expected["brave"] = 11;
+    durable.close();
+    //关闭后的写操作被拒绝，不会出现在重新打开的内容中
+    cout << "durable closed insert:" << durable.insert(make_pair(string("bravo"), 12)) << endl;
+    cout << "durable after truncate:" << durable.open(dir) << " " << same_content(durable, expected) << endl;
+    durable.close();
+
+    for_each_file(dir, "", [](const string &path) { unlink(path.c_str()); });
+    rmdir(dir.c_str());
+}
+
+bool same_content(radix_paged_tree<int> &paged, const map<string, int> &expected)
+{
+    vector<pair<string, int> > all;
+    paged.prefix_match("", all);
+    return all == vector<pair<string, int> >(expected.begin(), expected.end());
+}
+
+/**
+ * 随机插入和删除使容器页分裂，每步与std::map比较查找结果，关闭后重新打开，最后全部删除
+ */
+void paged_tree()
+{
+    char name[] = "/tmp/radix_paged_XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0)
+        return;
+    close(fd);
+
+    vector<string> words;
+    for (it_radix = tree.begin(); it_radix != tree.end(); ++it_radix)
+        words.push_back(it_radix->first);
+    map<string, int> expected;
+    bool same = true;
+    srand(1);
+    {
+        //缓冲池只有8个页，大部分访问需要换入换出
+        radix_paged_tree<int> paged(8);
+        paged.open(name);
+        for (int i = 0; i < 3000 && same; i++)
+        {
+            string key = words[rand() % words.size()];
+            for (int n = rand() % 4; n > 0; n--)
+                key += "/" + to_string(rand() % 50);
+            if (rand() % 4 != 0)
+                same = paged.insert(make_pair(key, i)) == expected.insert(make_pair(key, i)).second;
+            else
+                same = paged.erase(key) == (expected.erase(key) == 1);
+
+            int value;
+            string match;
+            map<string, int>::iterator it_map = expected.find(key);
+            same = same && paged.find(key, value) == (it_map != expected.end()) && (it_map == expected.end() || value == it_map->second);
+
+            //最长前缀匹配与std::map中逐个长度查找的结果比较
+            string query = key + "/x";
+            size_t len = query.size() + 1;
+            while (len > 0 && expected.count(query.substr(0, len - 1)) == 0)
+                len--;
+            bool found = paged.longest_match(query, match, value);
+            same = same && found == (len > 0) && (!found || (match.size() == len - 1 && value == expected[match]));
+        }
+        same = same && same_content(paged, expected);
+        cout << "paged insert:" << (same ? "same" : "different") << " pages:" << paged.pool().page_count() << endl;
+    }
+
+    radix_paged_tree<int> paged(8);
+    bool opened = paged.open(name);
+    cout << "paged reopen:" << opened << " " << (same_content(paged, expected) ? "same" : "different") << endl;
+
+    vector<pair<string, int> > vec;
+    paged.prefix_match("bi", vec);
+    cout << "paged prefix_match(bi):" << vec.size() << endl;
+
+    //删除全部元素，清空的页进入空闲链表
+    for (map<string, int>::iterator it_map = expected.begin(); it_map != expected.end(); ++it_map)
+        paged.erase(it_map->first);
+    paged.close();
+    opened = paged.open(name);
+    paged.prefix_match("", vec);
+    cout << "paged erase all:" << opened << " " << paged.size() << " " << vec.size() << endl;
+    paged.close();
+    unlink(name);
+}
+
+void topic_match(string topic)
+{
+    radix_tree<string, int> subscriptions;
+    subscriptions["sensors/+/temp"] = 0;
+    subscriptions["sensors/kitchen/#"] = 1;
+    subscriptions["sensors/kitchen/temp"] = 2;
+    subscriptions["logs/#"] = 3;
+    subscriptions["#"] = 4;
+
+    radix_topic_matcher<int> matcher(subscriptions);
+    vector<radix_tree<string, int>::iterator> matched;
+    matcher.match(topic, matched);
+    cout << "topic_match(" << topic << ")" << endl;
+    for (it_vec = matched.begin(); it_vec != matched.end(); ++it_vec)
+        cout << (*it_vec)->first << endl;
+}
+
 int main(int argc, char const *argv[])
 {
     insert();
@@ -85,4 +408,20 @@ int main(int argc, char const *argv[])
 
     tree.erase("bro");
     prefix_match("bro");
+
+    tree.compact();
+    prefix_match("b");
+
+    set_operation();
+    compact_steps();
+    burst_tree();
+    persistent_tree();
+    durable_tree();
+    paged_tree();
+    compact_tree();
+    scan_text("a blind binder with a bracelet");
+
+    topic_match("sensors/kitchen/temp");
+    topic_match("sensors/kitchen");
+    topic_match("logs");
 }
\ No newline at end of file